@@ -17,12 +17,14 @@
 #define PIPE_TYPE int
 #define PIPE_CREATE(p) _pipe(p, 512, _O_BINARY)
 #define PIPE_WRITE(p, buf, n) do { int _wr = _write((p)[1], (buf), (n)); if (_wr < 0) {} } while(0)
+#define PIPE_READ(fd, buf, n) _read((fd), (buf), (n))
 #define PIPE_CLOSE(p) { _close((p)[0]); _close((p)[1]); }
 #else
 #include <pthread.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/uio.h>
+#include <poll.h>
 #define THREAD_TYPE pthread_t
 #define THREAD_CREATE(thr, fn, arg) pthread_create((thr), NULL, (fn), (arg))
 #define THREAD_JOIN(thr) pthread_join((thr), NULL)
@@ -30,13 +32,16 @@
 #define PIPE_TYPE int
 #define PIPE_CREATE(p) pipe(p)
 #define PIPE_WRITE(p, buf, n) do { ssize_t _wr = write((p)[1], (buf), (n)); if (_wr < 0) {} } while(0)
+#define PIPE_READ(fd, buf, n) read((fd), (buf), (n))
 #define PIPE_CLOSE(p) { close((p)[0]); close((p)[1]); }
 #endif
 
-// Global list of running servers with thread safety
-#define MAX_SERVERS 16
-static go_server_t* server_list[MAX_SERVERS] = {NULL};
+// Global list of running servers with thread safety. The array grows on
+// demand; entries are kept packed at [0, server_count).
+static go_server_t** server_list = NULL;
 static int server_count = 0;
+static int server_capacity = 0;
+static int next_server_id = 1; // only touched from the R main thread
 #ifndef _WIN32
 static pthread_mutex_t server_list_mutex = PTHREAD_MUTEX_INITIALIZER;
 #define LOCK_SERVER_LIST() pthread_mutex_lock(&server_list_mutex)
@@ -51,31 +56,162 @@ static int server_list_cs_init = 0;
 // Helper: add/remove/list servers (thread-safe)
 static int add_server(go_server_t* srv) {
     LOCK_SERVER_LIST();
-    for (int i = 0; i < MAX_SERVERS; ++i) {
-        if (server_list[i] == NULL) {
-            server_list[i] = srv;
-            server_count++;
+    if (server_count == server_capacity) {
+        int capacity = server_capacity ? 2 * server_capacity : 16;
+        go_server_t** list = (go_server_t**)realloc(server_list, capacity * sizeof(go_server_t*));
+        if (!list) {
             UNLOCK_SERVER_LIST();
-            return i;
+            return -1;
         }
+        server_list = list;
+        server_capacity = capacity;
     }
+    int i = server_count++;
+    server_list[i] = srv;
     UNLOCK_SERVER_LIST();
-    return -1;
+    return i;
 }
 
-static void remove_server(go_server_t* srv) {
-    LOCK_SERVER_LIST();
-    for (int i = 0; i < MAX_SERVERS; ++i) {
+// Drop srv from the list; the caller holds the lock
+static void unlink_server(go_server_t* srv) {
+    for (int i = 0; i < server_count; ++i) {
         if (server_list[i] == srv) {
-            server_list[i] = NULL;
-            server_count--;
-            UNLOCK_SERVER_LIST();
+            server_list[i] = server_list[--server_count];
+            server_list[server_count] = NULL;
             return;
         }
     }
+}
+
+static void remove_server(go_server_t* srv) {
+    LOCK_SERVER_LIST();
+    unlink_server(srv);
     UNLOCK_SERVER_LIST();
 }
 
+// Helper: join the R "key=value" option vector into the newline-separated
+// string handed to Go
+static char* join_server_options(SEXP r_options) {
+    size_t total_len = 1;
+    int n = (r_options == R_NilValue) ? 0 : LENGTH(r_options);
+    for (int i = 0; i < n; i++) {
+        total_len += strlen(CHAR(STRING_ELT(r_options, i))) + 1;
+    }
+    char* options = (char*)malloc(total_len);
+    options[0] = '\0';
+    for (int i = 0; i < n; i++) {
+        if (i > 0) strcat(options, "\n");
+        strcat(options, CHAR(STRING_ELT(r_options, i)));
+    }
+    return options;
+}
+
+// Helper: look up one option value; returns a malloc'd copy or NULL
+static char* get_server_option(const char* options, const char* key) {
+    size_t key_len = strlen(key);
+    const char* line = options;
+    while (line && *line) {
+        const char* end = strchr(line, '\n');
+        size_t line_len = end ? (size_t)(end - line) : strlen(line);
+        if (line_len > key_len && strncmp(line, key, key_len) == 0 && line[key_len] == '=') {
+            size_t value_len = line_len - key_len - 1;
+            char* value = (char*)malloc(value_len + 1);
+            memcpy(value, line + key_len + 1, value_len);
+            value[value_len] = '\0';
+            return value;
+        }
+        line = end ? end + 1 : NULL;
+    }
+    return NULL;
+}
+
+// Helper: integer option value with a default
+static int get_server_option_int(const char* options, const char* key, int def) {
+    char* value = get_server_option(options, key);
+    if (!value) return def;
+    char* end = NULL;
+    long parsed = strtol(value, &end, 10);
+    int result = (end && end != value && *end == '\0') ? (int)parsed : def;
+    free(value);
+    return result;
+}
+
+// Helper: allocate the shared log ring if log_transport = "ring" was requested
+static goserver_log_ring_t* create_log_ring(const char* options) {
+    char* transport = get_server_option(options, "log_transport");
+    goserver_log_ring_t* ring = NULL;
+    if (transport && strcmp(transport, "ring") == 0) {
+        ring = (goserver_log_ring_t*)calloc(1, sizeof(goserver_log_ring_t));
+    }
+    if (transport) free(transport);
+    return ring;
+}
+
+// Helper: unregister and release the log handler of a server that is being
+// torn down, before its pipe and ring go away, so no input callback is left
+// reading a closed fd or a freed ring
+static void drop_log_handler(go_server_t* srv) {
+    if (srv->log_handler == R_NilValue) return;
+    SEXP goserveR_ns = PROTECT(R_FindNamespace(mkString("goserveR")));
+    SEXP remove_handler = PROTECT(Rf_findFun(Rf_install("removeLogHandler"), goserveR_ns));
+    if (remove_handler != R_UnboundValue) {
+        R_tryEval(lang2(remove_handler, srv->log_handler), goserveR_ns, NULL);
+    }
+    UNPROTECT(2);
+    // A no-op once removed; detaches the ring if the removal failed
+    if (srv->log_ring) attach_log_ring(srv->log_handler, NULL);
+    R_ReleaseObject(srv->log_handler);
+    srv->log_handler = R_NilValue;
+}
+
+// Helper: read one lifecycle event line ("ready <addr>", "error <message>",
+// "stopped") from the event pipe, blocking. Returns 0 at EOF.
+static int read_server_event(int fd, char* buf, size_t size) {
+    size_t n = 0;
+    char c;
+    for (;;) {
+        if (PIPE_READ(fd, &c, 1) != 1) {
+            buf[n] = '\0';
+            return n > 0;
+        }
+        if (c == '\n') break;
+        if (n < size - 1) buf[n++] = c;
+    }
+    buf[n] = '\0';
+    return 1;
+}
+
+// Helper: wait until the Go side has bound its listeners or failed to.
+// On success the server address is updated to the bound one (so ":0"
+// reports the actual port) and NULL is returned; otherwise the malloc'd
+// error message. Later events stay in the pipe for server_events().
+static char* wait_server_ready(go_server_t* srv) {
+    char event[1024];
+    while (read_server_event(srv->event_pipe[0], event, sizeof(event))) {
+        if (strncmp(event, "ready ", 6) == 0) {
+            char* addr = strdup(event + 6);
+            LOCK_SERVER_LIST();
+            free(srv->addr);
+            srv->addr = addr;
+            UNLOCK_SERVER_LIST();
+            return NULL;
+        }
+        if (strncmp(event, "error ", 6) == 0) {
+            return strdup(event + 6);
+        }
+        if (strcmp(event, "stopped") == 0) break;
+    }
+    return strdup("server stopped before it was ready");
+}
+
+#ifndef _WIN32
+// Helper: wait up to timeout_ms for an event; 1 if one can be read
+static int server_event_pending(int fd, int timeout_ms) {
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    return poll(&pfd, 1, timeout_ms) > 0;
+}
+#endif
+
 static void* server_thread_fn(void* arg) {
     go_server_t* srv = (go_server_t*)arg;
     
@@ -95,6 +231,7 @@ static void* server_thread_fn(void* arg) {
     HANDLE dup_shutdown = INVALID_HANDLE_VALUE;
     HANDLE dup_log = INVALID_HANDLE_VALUE;
     HANDLE dup_auth = INVALID_HANDLE_VALUE;
+    HANDLE dup_event = INVALID_HANDLE_VALUE;
 
     DuplicateHandle(proc, (HANDLE)_get_osfhandle(srv->shutdown_pipe[0]),
                     proc, &dup_shutdown, 0, FALSE, DUPLICATE_SAME_ACCESS);
@@ -104,19 +241,25 @@ static void* server_thread_fn(void* arg) {
         DuplicateHandle(proc, (HANDLE)_get_osfhandle(auth_pipe_fd),
                         proc, &dup_auth, 0, FALSE, DUPLICATE_SAME_ACCESS);
     }
+    DuplicateHandle(proc, (HANDLE)_get_osfhandle(srv->event_pipe[1]),
+                    proc, &dup_event, 0, FALSE, DUPLICATE_SAME_ACCESS);
 
     intptr_t shutdown_handle = (intptr_t)dup_shutdown;
     intptr_t log_handle = (intptr_t)dup_log;
     intptr_t auth_handle = (auth_pipe_fd >= 0) ? (intptr_t)dup_auth : (intptr_t)-1;
+    intptr_t event_handle = (intptr_t)dup_event;
 #else
     intptr_t shutdown_handle = (intptr_t)srv->shutdown_pipe[0];
     intptr_t log_handle = (intptr_t)srv->log_pipe[1];
     intptr_t auth_handle = (intptr_t)auth_pipe_fd;
+    // Go owns the write end of the event pipe and closes it when done, so
+    // the reader sees EOF after the last event
+    intptr_t event_handle = (intptr_t)srv->event_pipe[1];
 #endif
     
     // For backward compatibility, pass empty string for auth_keys
     // Auth is now handled via pipe-based system per server
-    RunServerWithLogging(srv->dirs, srv->addr, srv->prefixes, srv->num_paths, srv->cors, srv->coop, srv->tls, srv->silent, srv->certfile, srv->keyfile, shutdown_handle, log_handle, "", auth_handle);
+    RunServerWithLogging(srv->dirs, srv->addr, srv->prefixes, srv->num_paths, srv->cors, srv->coop, srv->tls, srv->silent, srv->certfile, srv->keyfile, shutdown_handle, log_handle, "", auth_handle, srv->options, srv->log_ring, srv->id, event_handle);
     
     // Safely update running status
     LOCK_SERVER_LIST();
@@ -126,7 +269,7 @@ static void* server_thread_fn(void* arg) {
     return NULL;
 }
 
-SEXP run_server(SEXP r_dir, SEXP r_addr, SEXP r_prefix, SEXP r_blocking, SEXP r_cors, SEXP r_coop, SEXP r_tls, SEXP r_certfile, SEXP r_keyfile, SEXP r_silent, SEXP r_log_handler, SEXP r_auth_keys) {
+SEXP run_server(SEXP r_dir, SEXP r_addr, SEXP r_prefix, SEXP r_blocking, SEXP r_cors, SEXP r_coop, SEXP r_tls, SEXP r_certfile, SEXP r_keyfile, SEXP r_silent, SEXP r_log_handler, SEXP r_auth_keys, SEXP r_options) {
     // Check that inputs are character vectors - now allowing vectors for dir and prefix
     if (TYPEOF(r_dir) != STRSXP || LENGTH(r_dir) < 1 ||
         TYPEOF(r_addr) != STRSXP || LENGTH(r_addr) != 1 ||
@@ -156,6 +299,11 @@ SEXP run_server(SEXP r_dir, SEXP r_addr, SEXP r_prefix, SEXP r_blocking, SEXP r_
         error("auth_keys must be a character vector or NULL");
     }
     
+    // Validate options: must be character vector or NULL
+    if (r_options != R_NilValue && TYPEOF(r_options) != STRSXP) {
+        error("options must be a character vector or NULL");
+    }
+    
     int num_paths = LENGTH(r_dir);
     const char* addr = CHAR(STRING_ELT(r_addr, 0));
     int blocking = LOGICAL(r_blocking)[0];
@@ -188,6 +336,7 @@ SEXP run_server(SEXP r_dir, SEXP r_addr, SEXP r_prefix, SEXP r_blocking, SEXP r_
     
     PIPE_TYPE shutdown_pipe[2];
     PIPE_TYPE log_pipe[2];
+    PIPE_TYPE event_pipe[2];
     
     if (PIPE_CREATE(shutdown_pipe) != 0) {
         error("Failed to create shutdown pipe");
@@ -196,6 +345,11 @@ SEXP run_server(SEXP r_dir, SEXP r_addr, SEXP r_prefix, SEXP r_blocking, SEXP r_
         PIPE_CLOSE(shutdown_pipe);
         error("Failed to create log pipe");
     }
+    if (PIPE_CREATE(event_pipe) != 0) {
+        PIPE_CLOSE(shutdown_pipe);
+        PIPE_CLOSE(log_pipe);
+        error("Failed to create event pipe");
+    }
     if (blocking) {
         go_server_t* srv = (go_server_t*)calloc(1, sizeof(go_server_t));
         
@@ -222,10 +376,17 @@ SEXP run_server(SEXP r_dir, SEXP r_addr, SEXP r_prefix, SEXP r_blocking, SEXP r_
         srv->shutdown_pipe[1] = shutdown_pipe[1];
         srv->log_pipe[0] = log_pipe[0];
         srv->log_pipe[1] = log_pipe[1];
+        srv->event_pipe[0] = event_pipe[0];
+        srv->event_pipe[1] = event_pipe[1];
+        srv->event_handler = R_NilValue;
         srv->log_handler = R_NilValue;
         srv->original_log_function = R_NilValue;
-        srv->log_file_path = NULL;
         srv->auth_context = NULL;  // NEW: Initialize auth context to NULL
+        srv->options = join_server_options(r_options);
+        srv->id = next_server_id++;
+        // A native log file is written by Go directly and needs no R handler
+        srv->log_file_path = get_server_option(srv->options, "log_file");
+        srv->log_ring = (silent || srv->log_file_path) ? NULL : create_log_ring(srv->options);
         
         // Create auth context if auth keys are provided (for compatibility)
         if (auth_keys_str && strlen(auth_keys_str) > 0) {
@@ -233,7 +394,7 @@ SEXP run_server(SEXP r_dir, SEXP r_addr, SEXP r_prefix, SEXP r_blocking, SEXP r_
         }
         
         // Setup log handler based on parameters
-        if (!silent) {
+        if (!silent && !srv->log_file_path) {
             if (r_log_handler != R_NilValue) {
                 // Store the original log function
                 srv->original_log_function = r_log_handler;
@@ -263,19 +424,44 @@ SEXP run_server(SEXP r_dir, SEXP r_addr, SEXP r_prefix, SEXP r_blocking, SEXP r_
             }
         }
         
+        // Switch the log handler to line-framed batches if requested
+        if (srv->log_handler != R_NilValue && get_server_option_int(srv->options, "log_batch", 0)) {
+            configure_log_batch(srv->log_handler,
+                                get_server_option_int(srv->options, "log_batch_lines", 0),
+                                get_server_option_int(srv->options, "log_batch_interval", 0));
+        }
+        
+        // Hand the log ring to the log handler; without one Go falls back to the pipe
+        if (srv->log_ring) {
+            if (srv->log_handler != R_NilValue) {
+                attach_log_ring(srv->log_handler, srv->log_ring);
+            } else {
+                free(srv->log_ring);
+                srv->log_ring = NULL;
+            }
+        }
+        
         if (THREAD_CREATE(&srv->thread, server_thread_fn, srv) != 0) {
+            drop_log_handler(srv);
             PIPE_CLOSE(shutdown_pipe);
             PIPE_CLOSE(log_pipe);
-            if (srv->log_handler != R_NilValue) R_ReleaseObject(srv->log_handler);
+            PIPE_CLOSE(event_pipe);
             // Auth context cleanup is handled by finalizer  // Free auth keys from struct
             if (auth_keys_str) free(auth_keys_str);  // Free local auth keys string
             for (int i = 0; i < num_paths; i++) {
                 free(srv->dirs[i]); free(srv->prefixes[i]);
             }
-            free(srv->dirs); free(srv->prefixes); free(srv->addr); free(srv->certfile); free(srv->keyfile); free(srv);
+            free(srv->dirs); free(srv->prefixes); free(srv->addr); free(srv->certfile); free(srv->keyfile);
+            free(srv->options); free(srv->log_file_path); if (srv->log_ring) free(srv->log_ring); free(srv);
             error("Failed to start server thread");
         }
-        Rprintf("Server started in blocking mode. Press Ctrl+C to interrupt.\n");
+        char* start_error = wait_server_ready(srv);
+        if (start_error) {
+            Rprintf("Server failed to start: %s\n", start_error);
+            free(start_error);
+        } else {
+            Rprintf("Server started in blocking mode. Press Ctrl+C to interrupt.\n");
+        }
         Rprintf("Server address: %s\n", srv->addr);
         Rprintf("Static files directories: %d paths\n", srv->num_paths);
         for (int i = 0; i < srv->num_paths; i++) {
@@ -287,21 +473,36 @@ SEXP run_server(SEXP r_dir, SEXP r_addr, SEXP r_prefix, SEXP r_blocking, SEXP r_
                 PIPE_WRITE(shutdown_pipe, "x", 1);
                 break;
             }
+#ifndef _WIN32
+            // Wake up as soon as the server reports an error or stops
+            if (server_event_pending(event_pipe[0], 200)) {
+                char event[1024];
+                if (!read_server_event(event_pipe[0], event, sizeof(event))) break;
+                if (strncmp(event, "error ", 6) == 0) Rprintf("Server error: %s\n", event + 6);
+            }
+#else
             SLEEP_MS(200);
+#endif
         }
         THREAD_JOIN(srv->thread);
         srv->running = 0;
         remove_server(srv);
+        drop_log_handler(srv);
         PIPE_CLOSE(shutdown_pipe);
         PIPE_CLOSE(log_pipe);
-        if (srv->log_handler != R_NilValue) R_ReleaseObject(srv->log_handler);
+#ifdef _WIN32
+        PIPE_CLOSE(event_pipe);
+#else
+        close(event_pipe[0]); // Go closed the write end
+#endif
         if (srv->original_log_function != R_NilValue) R_ReleaseObject(srv->original_log_function);
         if (srv->log_file_path) free(srv->log_file_path);
         // Auth context cleanup is handled by finalizer  // NEW: Free auth keys
         for (int i = 0; i < srv->num_paths; i++) {
             free(srv->dirs[i]); free(srv->prefixes[i]);
         }
-        free(srv->dirs); free(srv->prefixes); free(srv->addr); free(srv->certfile); free(srv->keyfile); free(srv);
+        free(srv->dirs); free(srv->prefixes); free(srv->addr); free(srv->certfile); free(srv->keyfile);
+        free(srv->options); if (srv->log_ring) free(srv->log_ring); free(srv);
         if (auth_keys_str) free(auth_keys_str);  // NEW: Free local auth keys string
         return R_NilValue;
     } else {
@@ -330,10 +531,17 @@ SEXP run_server(SEXP r_dir, SEXP r_addr, SEXP r_prefix, SEXP r_blocking, SEXP r_
         srv->shutdown_pipe[1] = shutdown_pipe[1];
         srv->log_pipe[0] = log_pipe[0];
         srv->log_pipe[1] = log_pipe[1];
+        srv->event_pipe[0] = event_pipe[0];
+        srv->event_pipe[1] = event_pipe[1];
+        srv->event_handler = R_NilValue;
         srv->log_handler = R_NilValue;
         srv->original_log_function = R_NilValue;
-        srv->log_file_path = NULL;
         srv->auth_context = NULL;  // NEW: Initialize auth context to NULL
+        srv->options = join_server_options(r_options);
+        srv->id = next_server_id++;
+        // A native log file is written by Go directly and needs no R handler
+        srv->log_file_path = get_server_option(srv->options, "log_file");
+        srv->log_ring = (silent || srv->log_file_path) ? NULL : create_log_ring(srv->options);
         
         // Create auth context if auth keys are provided (for compatibility)
         if (auth_keys_str && strlen(auth_keys_str) > 0) {
@@ -341,7 +549,7 @@ SEXP run_server(SEXP r_dir, SEXP r_addr, SEXP r_prefix, SEXP r_blocking, SEXP r_
         }
         
         // Setup log handler based on parameters
-        if (!silent) {
+        if (!silent && !srv->log_file_path) {
             if (r_log_handler != R_NilValue) {
                 // Store the original log function
                 srv->original_log_function = r_log_handler;
@@ -372,19 +580,46 @@ SEXP run_server(SEXP r_dir, SEXP r_addr, SEXP r_prefix, SEXP r_blocking, SEXP r_
             }
         }
         
+        // Switch the log handler to line-framed batches if requested
+        if (srv->log_handler != R_NilValue && get_server_option_int(srv->options, "log_batch", 0)) {
+            configure_log_batch(srv->log_handler,
+                                get_server_option_int(srv->options, "log_batch_lines", 0),
+                                get_server_option_int(srv->options, "log_batch_interval", 0));
+        }
+        
+        // Hand the log ring to the log handler; without one Go falls back to the pipe
+        if (srv->log_ring) {
+            if (srv->log_handler != R_NilValue) {
+                attach_log_ring(srv->log_handler, srv->log_ring);
+            } else {
+                free(srv->log_ring);
+                srv->log_ring = NULL;
+            }
+        }
+        
         if (THREAD_CREATE(&srv->thread, server_thread_fn, srv) != 0) {
+            drop_log_handler(srv);
             PIPE_CLOSE(shutdown_pipe);
             PIPE_CLOSE(log_pipe);
-            if (srv->log_handler != R_NilValue) R_ReleaseObject(srv->log_handler);
+            PIPE_CLOSE(event_pipe);
             for (int i = 0; i < num_paths; i++) {
                 free(srv->dirs[i]); free(srv->prefixes[i]);
             }
-            free(srv->dirs); free(srv->prefixes); free(srv->addr); free(srv->certfile); free(srv->keyfile); free(srv);
+            free(srv->dirs); free(srv->prefixes); free(srv->addr); free(srv->certfile); free(srv->keyfile);
+            free(srv->options); free(srv->log_file_path); if (srv->log_ring) free(srv->log_ring); free(srv);
             error("Failed to start server thread");
         }
-        add_server(srv);
+        char* start_error = wait_server_ready(srv);
+        if (add_server(srv) < 0) {
+            warning("Out of memory registering the server; listServers() will not show it");
+        }
         SEXP extptr = PROTECT(R_MakeExternalPtr(srv, R_NilValue, R_NilValue));
         R_RegisterCFinalizerEx(extptr, go_server_finalizer, 1);
+        if (start_error) {
+            // runServer() reports it, and fails if mustWork = TRUE
+            setAttrib(extptr, install("start_error"), mkString(start_error));
+            free(start_error);
+        }
         if (auth_keys_str) free(auth_keys_str);  // NEW: Free local auth keys string
         UNPROTECT(1);
         return extptr;
@@ -403,8 +638,29 @@ typedef struct {
     char* log_handler_type_copy;
     char* log_destination_copy;
     char* log_function_info_copy;
+    int id;
 } server_snapshot_t;
 
+// Connection counters of a running server as "active=N, accepted=N, ..."
+// for listServers(). The caller frees the result.
+static char* connection_summary(int id) {
+    char* text = ServerCounters(id);
+    char* out = (char*)calloc(text ? strlen(text) + 1 : 1, 1);
+    if (!text) return out;
+    char* line = text;
+    char* end;
+    while ((end = strchr(line, '\n')) != NULL) {
+        *end = '\0';
+        if (strncmp(line, "conn_", 5) == 0) {
+            if (out[0]) strcat(out, ", ");
+            strcat(out, line + 5);
+        }
+        line = end + 1;
+    }
+    free(text);
+    return out;
+}
+
 static void free_server_snapshot(server_snapshot_t* snap) {
     if (!snap) return;
     if (snap->addr_copy) free(snap->addr_copy);
@@ -427,7 +683,7 @@ SEXP list_servers() {
     
     // Count active servers
     int active_count = 0;
-    for (int i = 0; i < MAX_SERVERS; ++i) {
+    for (int i = 0; i < server_count; ++i) {
         go_server_t* srv = server_list[i];
         if (srv && srv->running && srv->addr && srv->dirs && srv->prefixes && srv->num_paths > 0) {
             active_count++;
@@ -435,10 +691,14 @@ SEXP list_servers() {
     }
     
     // Take a complete snapshot of all server data under the lock
-    server_snapshot_t snapshots[MAX_SERVERS];
+    server_snapshot_t* snapshots = (server_snapshot_t*)calloc(active_count ? active_count : 1, sizeof(server_snapshot_t));
+    if (!snapshots) {
+        UNLOCK_SERVER_LIST();
+        error("Out of memory listing servers");
+    }
     int snap_count = 0;
     
-    for (int i = 0; i < MAX_SERVERS && snap_count < active_count; ++i) {
+    for (int i = 0; i < server_count && snap_count < active_count; ++i) {
         go_server_t* srv = server_list[i];
         if (!srv || !srv->running || !srv->addr || !srv->dirs || !srv->prefixes || srv->num_paths <= 0) {
             continue;
@@ -448,7 +708,8 @@ SEXP list_servers() {
         snap->addr_copy = strdup(srv->addr);
         snap->num_paths = srv->num_paths;
         snap->tls = srv->tls;
-        snap->silent = srv->silent;
+        snap->id = srv->id;
+        snap->silent = srv->silent && !srv->log_file_path;
         
         snap->dirs_copy = (char**)malloc(snap->num_paths * sizeof(char*));
         snap->prefixes_copy = (char**)malloc(snap->num_paths * sizeof(char*));
@@ -479,7 +740,10 @@ SEXP list_servers() {
         const char* log_destination = "none";
         const char* log_function_info = "none";
         
-        if (!srv->silent && srv->running) {
+        if (srv->log_file_path) {
+            log_handler_type = "native_file";
+            log_destination = srv->log_file_path;
+        } else if (!srv->silent && srv->running) {
             if (srv->original_log_function != R_NilValue) {
                 log_handler_type = "custom_function";
                 log_destination = "custom";
@@ -507,7 +771,7 @@ SEXP list_servers() {
     for (int i = 0; i < snap_count; ++i) {
         server_snapshot_t* snap = &snapshots[i];
         
-        SEXP info = PROTECT(allocVector(STRSXP, 9));
+        SEXP info = PROTECT(allocVector(STRSXP, 10));
         
         // Combine directories into a single string
         int dirs_size = 1;
@@ -544,6 +808,9 @@ SEXP list_servers() {
         SET_STRING_ELT(info, 6, mkChar(snap->log_destination_copy));
         SET_STRING_ELT(info, 7, mkChar(snap->log_function_info_copy));
         SET_STRING_ELT(info, 8, mkChar(snap->auth_status_copy));
+        char* connections = connection_summary(snap->id);
+        SET_STRING_ELT(info, 9, mkChar(connections));
+        free(connections);
         
         free(combined_dirs);
         free(combined_prefixes);
@@ -554,11 +821,33 @@ SEXP list_servers() {
         // Free snapshot data
         free_server_snapshot(snap);
     }
+    free(snapshots);
     
     UNPROTECT(1);
     return res;
 }
 
+// Unpin the vector published at path, or all of them for NULL. Only called
+// once Go has stopped reading them.
+static void release_published(go_server_t* srv, const char* path) {
+    int kept = 0;
+    for (int i = 0; i < srv->num_published; i++) {
+        published_raw_t* p = &srv->published[i];
+        if (path && strcmp(p->path, path) != 0) {
+            srv->published[kept++] = *p;
+            continue;
+        }
+        R_ReleaseObject(p->data);
+        free(p->path);
+    }
+    srv->num_published = kept;
+    if (!path) {
+        free(srv->published);
+        srv->published = NULL;
+        srv->published_capacity = 0;
+    }
+}
+
 SEXP shutdown_server(SEXP extptr) {
     if (TYPEOF(extptr) != EXTPTRSXP) return R_NilValue;  // Handle NULL and other types
     go_server_t* srv = (go_server_t*)R_ExternalPtrAddr(extptr);
@@ -572,32 +861,19 @@ SEXP shutdown_server(SEXP extptr) {
     }
     // ALWAYS remove from server list to prevent dangling pointers
     // even if Go thread already set running=0
-    for (int i = 0; i < MAX_SERVERS; ++i) {
-        if (server_list[i] == srv) {
-            server_list[i] = NULL;
-            server_count--;
-            break;
-        }
-    }
+    unlink_server(srv);
     UNLOCK_SERVER_LIST();
     
     if (was_running) {
         // Remove log handler first to prevent callbacks during shutdown
-        if (srv->log_handler != R_NilValue) {
-            SEXP goserveR_ns = PROTECT(R_FindNamespace(mkString("goserveR")));
-            SEXP remove_handler = PROTECT(Rf_findFun(Rf_install("removeLogHandler"), goserveR_ns));
-            if (remove_handler != R_UnboundValue) {
-                R_tryEval(lang2(remove_handler, srv->log_handler), goserveR_ns, NULL);
-            }
-            UNPROTECT(2);
-            R_ReleaseObject(srv->log_handler);
-            srv->log_handler = R_NilValue;
-        }
+        drop_log_handler(srv);
         
         // Send shutdown signal and wait for thread to complete
         PIPE_WRITE(srv->shutdown_pipe, "x", 1);
         THREAD_JOIN(srv->thread);
     }
+    // Go no longer reads published vectors once it has stopped
+    release_published(srv, NULL);
     return R_NilValue;
 }
 
@@ -614,34 +890,43 @@ void go_server_finalizer(SEXP extptr) {
     // ALWAYS remove from server list before freeing memory
     // This prevents dangling pointers in server_list when the Go thread
     // already set running=0 but the server wasn't removed from the list
-    for (int i = 0; i < MAX_SERVERS; ++i) {
-        if (server_list[i] == srv) {
-            server_list[i] = NULL;
-            server_count--;
-            break;
-        }
-    }
+    unlink_server(srv);
     UNLOCK_SERVER_LIST();
     
     if (was_running) {
         // Remove log handler first to prevent callbacks during shutdown
-        if (srv->log_handler != R_NilValue) {
-            SEXP goserveR_ns = PROTECT(R_FindNamespace(mkString("goserveR")));
-            SEXP remove_handler = PROTECT(Rf_findFun(Rf_install("removeLogHandler"), goserveR_ns));
-            if (remove_handler != R_UnboundValue) {
-                R_tryEval(lang2(remove_handler, srv->log_handler), goserveR_ns, NULL);
-            }
-            UNPROTECT(2);
-        }
+        drop_log_handler(srv);
         
         PIPE_WRITE(srv->shutdown_pipe, "x", 1);
         THREAD_JOIN(srv->thread);
     }
     
+    // Stop event delivery before its pipe goes away
+    if (srv->event_handler != R_NilValue) {
+        SEXP goserveR_ns = PROTECT(R_FindNamespace(mkString("goserveR")));
+        SEXP remove_handler = PROTECT(Rf_findFun(Rf_install("removeLogHandler"), goserveR_ns));
+        if (remove_handler != R_UnboundValue) {
+            R_tryEval(lang2(remove_handler, srv->event_handler), goserveR_ns, NULL);
+        }
+        UNPROTECT(2);
+        R_ReleaseObject(srv->event_handler);
+    }
+
+    release_published(srv, NULL);
+
     // Clean up resources
     PIPE_CLOSE(srv->shutdown_pipe);
     PIPE_CLOSE(srv->log_pipe);
-    if (srv->log_handler != R_NilValue) R_ReleaseObject(srv->log_handler);
+#ifdef _WIN32
+    PIPE_CLOSE(srv->event_pipe);
+#else
+    close(srv->event_pipe[0]); // Go closed the write end
+#endif
+    if (srv->log_handler != R_NilValue) {
+        // Detach the ring from a log handler that may still be registered
+        if (srv->log_ring) attach_log_ring(srv->log_handler, NULL);
+        R_ReleaseObject(srv->log_handler);
+    }
     if (srv->dirs && srv->prefixes) {
         for (int i = 0; i < srv->num_paths; i++) {
             if (srv->dirs[i]) free(srv->dirs[i]);
@@ -653,6 +938,10 @@ void go_server_finalizer(SEXP extptr) {
     if (srv->addr) free(srv->addr);
     if (srv->certfile) free(srv->certfile);
     if (srv->keyfile) free(srv->keyfile);
+    if (srv->options) free(srv->options);
+    if (srv->log_file_path) free(srv->log_file_path);
+    // The Go thread has been joined, so nothing writes to the ring anymore
+    if (srv->log_ring) free(srv->log_ring);
     // Clean up auth context
     if (srv->auth_context) {
         cleanup_auth_context(srv->auth_context);
@@ -676,3 +965,308 @@ SEXP is_running(SEXP extptr) {
     return ScalarLogical(running);
 }
 
+SEXP server_address(SEXP extptr) {
+    if (TYPEOF(extptr) != EXTPTRSXP) return R_NilValue;
+    go_server_t* srv = (go_server_t*)R_ExternalPtrAddr(extptr);
+    if (!srv) return R_NilValue;
+
+    LOCK_SERVER_LIST();
+    SEXP addr = PROTECT(mkString(srv->addr));
+    UNLOCK_SERVER_LIST();
+    UNPROTECT(1);
+    return addr;
+}
+
+SEXP server_events(SEXP extptr, SEXP callback) {
+    if (TYPEOF(extptr) != EXTPTRSXP) error("invalid server handle");
+    go_server_t* srv = (go_server_t*)R_ExternalPtrAddr(extptr);
+    if (!srv) error("invalid server handle");
+    if (srv->event_handler != R_NilValue) error("an event callback is already registered");
+
+    // Events are lines, so they go through a batching log handler
+    SEXP goserveR_ns = PROTECT(R_FindNamespace(mkString("goserveR")));
+    SEXP event_fd = PROTECT(ScalarInteger(srv->event_pipe[0]));
+    SEXP batch = PROTECT(ScalarLogical(1));
+    SEXP call = PROTECT(lang5(Rf_install("registerLogHandler"), event_fd, callback, R_NilValue, batch));
+    srv->event_handler = eval(call, goserveR_ns);
+    if (srv->event_handler != R_NilValue) {
+        R_PreserveObject(srv->event_handler);
+    }
+    UNPROTECT(4);
+    return R_NilValue;
+}
+
+
+// Helper: parse "name=value" lines into a named numeric vector; frees text
+static SEXP parse_counters(char* text) {
+    int n = 0;
+    for (const char* p = text; *p; p++) {
+        if (*p == '\n') n++;
+    }
+    SEXP res = PROTECT(allocVector(REALSXP, n));
+    SEXP names = PROTECT(allocVector(STRSXP, n));
+    int i = 0;
+    char* line = text;
+    while (i < n && *line) {
+        char* end = strchr(line, '\n');
+        if (!end) break;
+        *end = '\0';
+        char* eq = strchr(line, '=');
+        if (eq) {
+            *eq = '\0';
+            REAL(res)[i] = strtod(eq + 1, NULL);
+        } else {
+            REAL(res)[i] = NA_REAL;
+        }
+        SET_STRING_ELT(names, i, mkChar(line));
+        i++;
+        line = end + 1;
+    }
+    free(text);
+    setAttrib(res, R_NamesSymbol, names);
+    UNPROTECT(2);
+    return res;
+}
+
+SEXP get_server_counters(SEXP extptr) {
+    if (TYPEOF(extptr) != EXTPTRSXP) return R_NilValue;
+    go_server_t* srv = (go_server_t*)R_ExternalPtrAddr(extptr);
+    if (!srv) return R_NilValue;
+
+    // NULL once the Go side has stopped serving
+    char* text = ServerCounters(srv->id);
+    if (!text) return R_NilValue;
+    return parse_counters(text);
+}
+
+SEXP load_start(SEXP options) {
+    if (TYPEOF(options) != STRSXP) error("options must be a character vector");
+    char* joined = join_server_options(options);
+    char* err = NULL;
+    int id = StartLoad(joined, &err);
+    free(joined);
+    if (id < 0) {
+        char msg[512];
+        snprintf(msg, sizeof(msg), "%s", err ? err : "cannot start load");
+        free(err);
+        error("%s", msg);
+    }
+    return ScalarInteger(id);
+}
+
+SEXP load_result(SEXP id) {
+    char* text = LoadResult(asInteger(id));
+    if (!text) return R_NilValue; // still running
+    if (!text[0]) {
+        free(text);
+        error("unknown load run");
+    }
+    return parse_counters(text);
+}
+
+SEXP start_profile(SEXP type, SEXP file, SEXP rate) {
+    if (TYPEOF(type) != STRSXP || LENGTH(type) != 1 ||
+        TYPEOF(file) != STRSXP || LENGTH(file) != 1) {
+        error("type and file must be single strings");
+    }
+    char* err = StartProfile((char*)CHAR(STRING_ELT(type, 0)),
+                             (char*)CHAR(STRING_ELT(file, 0)),
+                             asInteger(rate));
+    if (err && err[0]) {
+        char msg[512];
+        snprintf(msg, sizeof(msg), "%s", err);
+        free(err);
+        error("%s", msg);
+    }
+    free(err);
+    return R_NilValue;
+}
+
+SEXP stop_profile(SEXP type) {
+    if (TYPEOF(type) != STRSXP || LENGTH(type) != 1) {
+        error("type must be a single string");
+    }
+    // "ok" followed by one written file per line, or an error message
+    char* text = StopProfiles((char*)CHAR(STRING_ELT(type, 0)));
+    if (strncmp(text, "ok", 2) != 0) {
+        char msg[512];
+        snprintf(msg, sizeof(msg), "%s", text);
+        free(text);
+        error("%s", msg);
+    }
+    int n = 0;
+    for (const char* p = text; *p; p++) {
+        if (*p == '\n') n++;
+    }
+    SEXP res = PROTECT(allocVector(STRSXP, n));
+    char* line = text + 2;
+    for (int i = 0; i < n; i++) {
+        line++; // skip the newline
+        char* end = strchr(line, '\n');
+        if (end) *end = '\0';
+        SET_STRING_ELT(res, i, mkChar(line));
+        if (!end) break;
+        line = end;
+    }
+    free(text);
+    UNPROTECT(1);
+    return res;
+}
+
+SEXP set_server_runtime(SEXP options) {
+    if (TYPEOF(options) != STRSXP) error("options must be a character vector");
+    char* joined = join_server_options(options);
+    char* text = SetRuntime(joined);
+    free(joined);
+    return parse_counters(text);
+}
+
+SEXP server_runtime_stats(void) {
+    return parse_counters(RuntimeStats());
+}
+
+SEXP server_query(SEXP extptr, SEXP what) {
+    if (TYPEOF(extptr) != EXTPTRSXP) return R_NilValue;
+    if (TYPEOF(what) != STRSXP || LENGTH(what) != 1) {
+        error("what must be a single string");
+    }
+    go_server_t* srv = (go_server_t*)R_ExternalPtrAddr(extptr);
+    if (!srv) return R_NilValue;
+
+    char* text = ServerQuery(srv->id, (char*)CHAR(STRING_ELT(what, 0)));
+    if (!text) return R_NilValue;
+    // Go recovered from a panic while building the report
+    if (strncmp(text, "query failed: ", 14) == 0) {
+        char message[512];
+        snprintf(message, sizeof(message), "%s", text);
+        free(text);
+        error("%s", message);
+    }
+    SEXP res = PROTECT(mkString(text));
+    free(text);
+    UNPROTECT(1);
+    return res;
+}
+
+SEXP server_command(SEXP extptr, SEXP command) {
+    if (TYPEOF(extptr) != EXTPTRSXP) return R_NilValue;
+    if (TYPEOF(command) != STRSXP || LENGTH(command) != 1) {
+        error("command must be a single string");
+    }
+    go_server_t* srv = (go_server_t*)R_ExternalPtrAddr(extptr);
+    if (!srv) return R_NilValue;
+
+    char* text = ServerCommand(srv->id, (char*)CHAR(STRING_ELT(command, 0)));
+    if (!text) return R_NilValue;
+    SEXP res = PROTECT(mkString(text));
+    free(text);
+    UNPROTECT(1);
+    return res;
+}
+
+SEXP publish_raw(SEXP extptr, SEXP path, SEXP data, SEXP content_type) {
+    if (TYPEOF(extptr) != EXTPTRSXP) return R_NilValue;
+    if (TYPEOF(path) != STRSXP || LENGTH(path) != 1 ||
+        TYPEOF(content_type) != STRSXP || LENGTH(content_type) != 1) {
+        error("path and content_type must be single strings");
+    }
+    if (TYPEOF(data) != RAWSXP) error("data must be a raw vector");
+    go_server_t* srv = (go_server_t*)R_ExternalPtrAddr(extptr);
+    if (!srv) return R_NilValue;
+
+    // Pin first: Go may serve the vector as soon as it is published
+    if (srv->num_published == srv->published_capacity) {
+        int capacity = srv->published_capacity ? 2 * srv->published_capacity : 8;
+        published_raw_t* list = (published_raw_t*)realloc(srv->published, capacity * sizeof(published_raw_t));
+        if (!list) error("cannot allocate memory");
+        srv->published = list;
+        srv->published_capacity = capacity;
+    }
+    const char* path_str = CHAR(STRING_ELT(path, 0));
+    char* path_copy = strdup(path_str);
+    if (!path_copy) error("cannot allocate memory");
+    // Assignments to the vector in R now copy it instead of writing to
+    // memory being served
+    MARK_NOT_MUTABLE(data);
+    R_PreserveObject(data);
+
+    char* text = PublishRaw(srv->id, path_copy, RAW(data), (long long)XLENGTH(data),
+                            (char*)CHAR(STRING_ELT(content_type, 0)));
+    if (!text || text[0]) {
+        R_ReleaseObject(data);
+        free(path_copy);
+        if (!text) return R_NilValue;
+        SEXP res = PROTECT(mkString(text));
+        free(text);
+        UNPROTECT(1);
+        return res;
+    }
+    free(text);
+    // Go has closed any vector previously published at this path
+    release_published(srv, path_copy);
+    srv->published[srv->num_published].path = path_copy;
+    srv->published[srv->num_published].data = data;
+    srv->num_published++;
+    return mkString("");
+}
+
+SEXP unpublish_raw(SEXP extptr, SEXP command, SEXP path) {
+    if (TYPEOF(path) != STRSXP || LENGTH(path) != 1) {
+        error("path must be a single string");
+    }
+    SEXP res = PROTECT(server_command(extptr, command));
+    // "" once Go has closed the object; NULL once the server has stopped,
+    // which closes all of them
+    if (res == R_NilValue || CHAR(STRING_ELT(res, 0))[0] == '\0') {
+        go_server_t* srv = (go_server_t*)R_ExternalPtrAddr(extptr);
+        if (srv) release_published(srv, CHAR(STRING_ELT(path, 0)));
+    }
+    UNPROTECT(1);
+    return res;
+}
+
+SEXP server_mount(SEXP extptr, SEXP command, SEXP dir, SEXP prefix) {
+    if (TYPEOF(prefix) != STRSXP || LENGTH(prefix) != 1) {
+        error("prefix must be a single string");
+    }
+    // dir is NULL when removing a mount
+    int adding = (dir != R_NilValue);
+    if (adding && (TYPEOF(dir) != STRSXP || LENGTH(dir) != 1)) {
+        error("dir must be a single string");
+    }
+    SEXP res = PROTECT(server_command(extptr, command));
+    if (res == R_NilValue || CHAR(STRING_ELT(res, 0))[0] != '\0') {
+        UNPROTECT(1);
+        return res;
+    }
+
+    go_server_t* srv = (go_server_t*)R_ExternalPtrAddr(extptr);
+    const char* prefix_str = CHAR(STRING_ELT(prefix, 0));
+    LOCK_SERVER_LIST();
+    if (adding) {
+        char** dirs = (char**)realloc(srv->dirs, (srv->num_paths + 1) * sizeof(char*));
+        if (dirs) srv->dirs = dirs;
+        char** prefixes = (char**)realloc(srv->prefixes, (srv->num_paths + 1) * sizeof(char*));
+        if (prefixes) srv->prefixes = prefixes;
+        if (dirs && prefixes) {
+            srv->dirs[srv->num_paths] = strdup(CHAR(STRING_ELT(dir, 0)));
+            srv->prefixes[srv->num_paths] = strdup(prefix_str);
+            srv->num_paths++;
+        }
+    } else {
+        for (int i = 0; i < srv->num_paths; i++) {
+            if (strcmp(srv->prefixes[i], prefix_str) != 0) continue;
+            free(srv->dirs[i]);
+            free(srv->prefixes[i]);
+            for (int j = i + 1; j < srv->num_paths; j++) {
+                srv->dirs[j - 1] = srv->dirs[j];
+                srv->prefixes[j - 1] = srv->prefixes[j];
+            }
+            srv->num_paths--;
+            break;
+        }
+    }
+    UNLOCK_SERVER_LIST();
+    UNPROTECT(1);
+    return res;
+}
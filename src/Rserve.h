@@ -11,6 +11,7 @@
 #include "libserve.h"
 #endif
 #include "interupt.h"
+#include "logring.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -33,8 +34,17 @@ typedef struct {
     char** current_keys;    // Array of current auth keys (for listing)
     int num_keys;           // Number of current keys
     int key_capacity;       // Allocated capacity for keys array
+    int* key_index;         // Hash index into current_keys (see auth.c)
+    int index_capacity;     // Slots in key_index, a power of two
+    int index_used;         // Occupied and deleted slots
 } auth_context_t;
 
+// An R raw vector served by Go straight from R memory
+typedef struct {
+    char* path;
+    SEXP data;          // Preserved while Go may read it
+} published_raw_t;
+
 // Struct to hold server state for background servers
 typedef struct {
     THREAD_TYPE thread; // Thread handle for background server
@@ -51,21 +61,30 @@ typedef struct {
     int running;
     PIPE_TYPE shutdown_pipe[2];
     PIPE_TYPE log_pipe[2];
+    PIPE_TYPE event_pipe[2]; // Lifecycle events from Go ("ready", "error", "stopped")
+    SEXP event_handler; // R log handler delivering events to the on_event callback
     SEXP log_handler; // R external pointer to log handler
     SEXP original_log_function; // Store the original R log function
     char* log_file_path; // Store log file path if available
     auth_context_t* auth_context; // NEW: Pipe-based auth context
+    char* options;      // Newline-separated key=value options passed to Go
+    goserver_log_ring_t* log_ring; // Shared log ring (log_transport = "ring")
+    int id;             // Identifies the server in Go-side queries
+    published_raw_t* published; // Vectors pinned by publishRaw()
+    int num_published;
+    int published_capacity;
     // Add more fields as needed
 } go_server_t;
 
 // Start a server; if blocking, runs in foreground, else background
-SEXP run_server(SEXP r_dir, SEXP r_addr, SEXP r_prefix, SEXP r_blocking, SEXP r_cors, SEXP r_coop, SEXP r_tls, SEXP r_certfile, SEXP r_keyfile, SEXP r_silent, SEXP r_log_handler, SEXP r_auth_keys);
+SEXP run_server(SEXP r_dir, SEXP r_addr, SEXP r_prefix, SEXP r_blocking, SEXP r_cors, SEXP r_coop, SEXP r_tls, SEXP r_certfile, SEXP r_keyfile, SEXP r_silent, SEXP r_log_handler, SEXP r_auth_keys, SEXP r_options);
 
 // Auth management functions (server-based)
 auth_context_t* create_server_auth_context(void);
 SEXP manage_server_auth(SEXP server_handle, SEXP key, SEXP action);
 SEXP list_server_auth_keys(SEXP server_handle);
 SEXP add_initial_server_auth_keys(SEXP server_handle, SEXP keys);
+SEXP set_server_auth_keys(SEXP server_handle, SEXP keys);
 void cleanup_auth_context(auth_context_t* ctx);
 
 
@@ -78,12 +97,61 @@ SEXP shutdown_server(SEXP extptr);
 // Check if a server is running
 SEXP is_running(SEXP extptr);
 
+// Counters of a running server as a named numeric vector
+SEXP get_server_counters(SEXP extptr);
+
+// Text report ("stats", "metrics") about a running server, NULL if stopped
+SEXP server_query(SEXP extptr, SEXP what);
+
+// Run a command ("reload_tls") on a running server; returns "" on success,
+// the error message otherwise, NULL if stopped
+SEXP server_command(SEXP extptr, SEXP command);
+
+// Add (dir, prefix) or remove (prefix) a mount of a running server via
+// server_command and mirror the change in dirs/prefixes
+SEXP server_mount(SEXP extptr, SEXP command, SEXP dir, SEXP prefix);
+
+// Deliver the remaining lifecycle events of a server to an R callback
+SEXP server_events(SEXP extptr, SEXP callback);
+
+// Address a server is listening on, with the actual port once bound
+SEXP server_address(SEXP extptr);
+
+// Start a benchmark load run (options as "key=value" strings); returns its id
+SEXP load_start(SEXP options);
+
+// Results of a load run as a named numeric vector, NULL while it runs
+SEXP load_result(SEXP id);
+
+// Start a process-wide Go profile (cpu, heap, goroutine, mutex, block)
+// written to file; rate is the mutex fraction or block rate, 0 for default
+SEXP start_profile(SEXP type, SEXP file, SEXP rate);
+
+// Stop the profile of a type, or all for "", returning the files written
+SEXP stop_profile(SEXP type);
+
+// Set GOMAXPROCS, the GC target and the memory limit of the Go runtime
+// (options as "key=value" strings); returns the previous settings
+SEXP set_server_runtime(SEXP options);
+
+// Go runtime settings and statistics as a named numeric vector
+SEXP server_runtime_stats(void);
+
+// Serve a raw vector at path without copying it; the vector stays pinned
+// until it is unpublished or replaced or the server is shut down
+SEXP publish_raw(SEXP extptr, SEXP path, SEXP data, SEXP content_type);
+
+// Stop serving a published path and unpin its vector
+SEXP unpublish_raw(SEXP extptr, SEXP command, SEXP path);
+
 // Internal: finalizer for go_server_t external pointer
 void go_server_finalizer(SEXP extptr);
 
 // Background log handler functions
-SEXP register_log_handler(SEXP s_fd, SEXP callback, SEXP user);
+SEXP register_log_handler(SEXP s_fd, SEXP callback, SEXP user, SEXP s_batch, SEXP s_batch_lines, SEXP s_batch_interval);
 SEXP remove_log_handler(SEXP h_ptr);
 void log_handler_finalizer(SEXP h_ptr);
+void attach_log_ring(SEXP h_ptr, goserver_log_ring_t* ring);
+void configure_log_batch(SEXP h_ptr, int lines, int interval_ms);
 
 #endif
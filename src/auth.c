@@ -18,19 +18,66 @@
 #define PIPE_CLOSE(fd) close(fd)
 #endif
 
+// Key index: open addressing with linear probing over key_index. A slot
+// holds 0 (empty), -1 (deleted) or position + 1 in current_keys, so lookups,
+// adds and removes are O(1) instead of scanning the key array.
+#define KEY_SLOT_EMPTY 0
+#define KEY_SLOT_DELETED -1
+
+static unsigned int hash_key(const char* key) {
+    unsigned int h = 2166136261u; // FNV-1a
+    for (const unsigned char* p = (const unsigned char*)key; *p; p++) {
+        h = (h ^ *p) * 16777619u;
+    }
+    return h;
+}
+
+// Slot of key in the index, or -1
+static int find_key_slot(auth_context_t* ctx, const char* key) {
+    if (ctx->index_capacity == 0) return -1;
+    unsigned int mask = (unsigned int)ctx->index_capacity - 1;
+    for (unsigned int i = hash_key(key) & mask;; i = (i + 1) & mask) {
+        int slot = ctx->key_index[i];
+        if (slot == KEY_SLOT_EMPTY) return -1;
+        if (slot > 0 && strcmp(ctx->current_keys[slot - 1], key) == 0) return (int)i;
+    }
+}
+
+static void index_insert(auth_context_t* ctx, const char* key, int pos) {
+    unsigned int mask = (unsigned int)ctx->index_capacity - 1;
+    unsigned int i = hash_key(key) & mask;
+    while (ctx->key_index[i] > 0) {
+        i = (i + 1) & mask;
+    }
+    if (ctx->key_index[i] == KEY_SLOT_EMPTY) ctx->index_used++;
+    ctx->key_index[i] = pos + 1;
+}
+
+// Rebuild the index with room for at least min_keys keys at load <= 1/2
+static void rebuild_key_index(auth_context_t* ctx, int min_keys) {
+    int capacity = 16;
+    while (capacity < 2 * min_keys) capacity *= 2;
+    int* index = (int*)calloc(capacity, sizeof(int));
+    if (!index) {
+        Rf_error("Failed to allocate auth key index");
+    }
+    free(ctx->key_index);
+    ctx->key_index = index;
+    ctx->index_capacity = capacity;
+    ctx->index_used = 0;
+    for (int i = 0; i < ctx->num_keys; i++) {
+        index_insert(ctx, ctx->current_keys[i], i);
+    }
+}
+
 // Helper: add key to tracking array
 static void add_key_to_list(auth_context_t* ctx, const char* key) {
     if (!ctx || !key || strlen(key) == 0) {
         return; // Invalid input
     }
     
-    // Check if key already exists (only if we have keys)
-    if (ctx->current_keys && ctx->num_keys > 0) {
-        for (int i = 0; i < ctx->num_keys && i < ctx->key_capacity; i++) {
-            if (ctx->current_keys[i] && strcmp(ctx->current_keys[i], key) == 0) {
-                return; // Already exists
-            }
-        }
+    if (find_key_slot(ctx, key) >= 0) {
+        return; // Already exists
     }
     
     // Expand array if needed
@@ -50,17 +97,19 @@ static void add_key_to_list(auth_context_t* ctx, const char* key) {
         }
     }
     
-    // Add new key - double check bounds
-    if (ctx->num_keys >= ctx->key_capacity) {
-        Rf_error("Key array capacity exceeded unexpectedly");
-    }
-    
     ctx->current_keys[ctx->num_keys] = (char*)malloc(strlen(key) + 1);
     if (!ctx->current_keys[ctx->num_keys]) {
         Rf_error("Failed to allocate key string");
     }
     strcpy(ctx->current_keys[ctx->num_keys], key);
     ctx->num_keys++;
+
+    // Deleted slots count towards the load, so rebuilding also purges them
+    if (2 * (ctx->index_used + 1) > ctx->index_capacity) {
+        rebuild_key_index(ctx, ctx->num_keys);
+    } else {
+        index_insert(ctx, key, ctx->num_keys - 1);
+    }
 }
 
 // Helper: remove key from tracking array
@@ -69,31 +118,21 @@ static void remove_key_from_list(auth_context_t* ctx, const char* key) {
         return; // Invalid input
     }
     
-    // Check if we have no keys or no array allocated
-    if (!ctx->current_keys || ctx->num_keys <= 0 || ctx->key_capacity <= 0) {
-        return; // Empty list or no allocation
+    int slot = find_key_slot(ctx, key);
+    if (slot < 0) {
+        return; // Key not found - this is handled gracefully
     }
+    int pos = ctx->key_index[slot] - 1;
+    ctx->key_index[slot] = KEY_SLOT_DELETED;
+    free(ctx->current_keys[pos]);
     
-    for (int i = 0; i < ctx->num_keys; i++) {
-        if (ctx->current_keys[i] && strcmp(ctx->current_keys[i], key) == 0) {
-            // Free the key string
-            free(ctx->current_keys[i]);
-            ctx->current_keys[i] = NULL;
-            
-            // Shift remaining keys down (properly compact the array)
-            for (int j = i; j < ctx->num_keys - 1; j++) {
-                ctx->current_keys[j] = ctx->current_keys[j + 1];
-            }
-            
-            // Decrement count and clear the last slot
-            ctx->num_keys--;
-            if (ctx->num_keys >= 0 && ctx->num_keys < ctx->key_capacity) {
-                ctx->current_keys[ctx->num_keys] = NULL;
-            }
-            return;
-        }
+    // Move the last key into the gap instead of shifting the array
+    int last = --ctx->num_keys;
+    if (pos != last) {
+        ctx->current_keys[pos] = ctx->current_keys[last];
+        ctx->key_index[find_key_slot(ctx, ctx->current_keys[pos])] = pos + 1;
     }
-    // Key not found - this is handled gracefully
+    ctx->current_keys[last] = NULL;
 }
 
 // Helper: clear all keys from tracking array
@@ -112,6 +151,10 @@ static void clear_all_keys(auth_context_t* ctx) {
         }
         ctx->num_keys = 0;
     }
+    if (ctx->key_index) {
+        memset(ctx->key_index, 0, ctx->index_capacity * sizeof(int));
+        ctx->index_used = 0;
+    }
 }
 
 // Helper: cleanup auth context
@@ -148,6 +191,8 @@ void cleanup_auth_context(auth_context_t* ctx) {
     }
     ctx->num_keys = 0;
     ctx->key_capacity = 0;
+    free(ctx->key_index);
+    ctx->key_index = NULL;
     
     free(ctx);
 }
@@ -176,6 +221,9 @@ auth_context_t* create_server_auth_context(void) {
     ctx->current_keys = NULL;
     ctx->num_keys = 0;
     ctx->key_capacity = 0;
+    ctx->key_index = NULL;
+    ctx->index_capacity = 0;
+    ctx->index_used = 0;
     
     return ctx;
 }
@@ -291,6 +339,41 @@ SEXP list_server_auth_keys(SEXP server_handle) {
     return result;
 }
 
+// Send the whole tracked key set to Go as one "SET:<n>" frame followed by
+// n key lines, which Go swaps in at once
+static void send_key_set(auth_context_t* ctx) {
+    if (ctx->auth_pipe_write_fd < 0) {
+        return;
+    }
+    size_t total = 32;
+    for (int i = 0; i < ctx->num_keys; i++) {
+        total += strlen(ctx->current_keys[i]) + 1;
+    }
+    char* buf = (char*)malloc(total);
+    if (!buf) {
+        Rf_error("Failed to allocate auth key batch");
+    }
+    size_t len = (size_t)snprintf(buf, 32, "SET:%d\n", ctx->num_keys);
+    for (int i = 0; i < ctx->num_keys; i++) {
+        size_t n = strlen(ctx->current_keys[i]);
+        memcpy(buf + len, ctx->current_keys[i], n);
+        len += n;
+        buf[len++] = '\n';
+    }
+    // Large batches take several writes while Go drains the pipe
+    size_t off = 0;
+    while (off < len) {
+        size_t chunk = len - off > 65536 ? 65536 : len - off;
+        long written = (long)PIPE_WRITE(ctx->auth_pipe_write_fd, buf + off, chunk);
+        if (written <= 0) {
+            Rf_warning("Failed to write auth keys to pipe");
+            break;
+        }
+        off += (size_t)written;
+    }
+    free(buf);
+}
+
 // Add initial auth keys to a server
 SEXP add_initial_server_auth_keys(SEXP server_handle, SEXP keys) {
     if (TYPEOF(server_handle) != EXTPTRSXP) {
@@ -314,21 +397,43 @@ SEXP add_initial_server_auth_keys(SEXP server_handle, SEXP keys) {
     
     int n_keys = LENGTH(keys);
     for (int i = 0; i < n_keys; i++) {
-        const char* key = CHAR(STRING_ELT(keys, i));
-        
-        // Send to Go (if pipe is valid)
-        if (ctx->auth_pipe_write_fd >= 0) {
-            char command[512];
-            snprintf(command, sizeof(command), "ADD:%s\n", key);
-            ssize_t written = PIPE_WRITE(ctx->auth_pipe_write_fd, command, strlen(command));
-            if (written == -1) {
-                Rf_warning("Failed to write initial auth key to pipe");
-            }
-        }
-        
-        // Add to local tracking
-        add_key_to_list(ctx, key);
+        add_key_to_list(ctx, CHAR(STRING_ELT(keys, i)));
+    }
+    send_key_set(ctx);
+    
+    return R_NilValue;
+}
+
+// Replace all auth keys of a server with one batch
+SEXP set_server_auth_keys(SEXP server_handle, SEXP keys) {
+    if (TYPEOF(server_handle) != EXTPTRSXP) {
+        Rf_error("Invalid server handle");
+    }
+    
+    if (TYPEOF(keys) != STRSXP) {
+        Rf_error("Keys must be a character vector");
+    }
+    
+    go_server_t* srv = (go_server_t*)R_ExternalPtrAddr(server_handle);
+    if (!srv) {
+        Rf_error("Server context is NULL");
+    }
+    
+    if (!srv->auth_context) {
+        Rf_error("Server has no auth context - auth not enabled for this server");
+    }
+    
+    auth_context_t* ctx = srv->auth_context;
+    
+    clear_all_keys(ctx);
+    int n_keys = LENGTH(keys);
+    if (2 * n_keys > ctx->index_capacity) {
+        rebuild_key_index(ctx, n_keys);
+    }
+    for (int i = 0; i < n_keys; i++) {
+        add_key_to_list(ctx, CHAR(STRING_ELT(keys, i)));
     }
+    send_key_set(ctx);
     
     return R_NilValue;
 }
@@ -17,6 +17,12 @@
 #include <Rinternals.h>
 #include <R_ext/Visibility.h>
 #include <R_ext/Boolean.h>
+#include <time.h>
+#include "logring.h"
+
+/* cap on bytes read per wakeup and on a single unterminated line */
+#define LOG_READ_CHUNK 65536
+#define LOG_MAX_PARTIAL 65536
 
 #define BackgroundActivity 10
 
@@ -25,6 +31,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <poll.h>
 #else
 #include <windows.h>
 #include <io.h>  /* for _read, _write, _close */
@@ -32,12 +39,24 @@
 
 static int in_process;
 
+/* growable text buffer used to collect log text before delivery */
+typedef struct {
+    char *buf;
+    size_t len, cap;
+} log_text_t;
+
 typedef struct bg_log_handler {
     struct bg_log_handler *next, *prev;
     int fd;
     SEXP callback;
     SEXP user;
     SEXP self;
+    goserver_log_ring_t *ring; /* shared log ring, NULL for text pipes */
+    int batch;            /* deliver complete lines as a character vector */
+    int batch_lines;      /* deliver once this many lines are pending (0 = any) */
+    int batch_interval;   /* hold lines up to this many ms (0 = deliver at once) */
+    double pending_since; /* time the oldest pending line arrived (ms) */
+    log_text_t pending;   /* received text; complete lines followed by a partial one */
 #ifdef WIN32
     struct bg_log_message *msg_head;
     struct bg_log_message *msg_tail;
@@ -80,6 +99,8 @@ static LRESULT CALLBACK BackgroundWindowProc(HWND hwnd, UINT uMsg, WPARAM wParam
 
 static int needs_init = 1;
 
+static void batch_timer_remove(void);
+
 static void first_init()
 {
 #ifdef WIN32
@@ -136,6 +157,13 @@ static void finalize_log_handler(bg_log_handler_t *h)
     if (h->fd >= 0) {
         h->fd = -1;
     }
+
+    if (h->batch && h->batch_interval > 0)
+        batch_timer_remove();
+    h->batch = 0;
+    free(h->pending.buf);
+    h->pending.buf = NULL;
+    h->pending.len = h->pending.cap = 0;
     
     LOCK_LOG_HANDLERS();
     if (h->prev) {
@@ -164,6 +192,269 @@ static void run_log_callback(bg_log_handler_t *h)
 #define run_log_callback run_log_callback_main_thread
 #endif
 
+static void log_text_append(log_text_t *t, const char *s, size_t n)
+{
+    if (t->len + n + 1 > t->cap) {
+        size_t cap = t->cap ? t->cap : 4096;
+        while (t->len + n + 1 > cap) cap *= 2;
+        char *buf = (char*) realloc(t->buf, cap);
+        if (!buf) return;
+        t->buf = buf;
+        t->cap = cap;
+    }
+    memcpy(t->buf + t->len, s, n);
+    t->len += n;
+    t->buf[t->len] = '\0';
+}
+
+/* format a duration the way Go's time.Duration prints it */
+static void format_duration(int64_t ns, char *out, size_t size)
+{
+    const char *unit = "s";
+    int decimals = 9;
+    double value = (double) ns / 1e9;
+    if (ns < 1000) {
+        snprintf(out, size, "%lldns", (long long) ns);
+        return;
+    } else if (ns < 1000000) {
+        unit = "\xC2\xB5s"; value = (double) ns / 1e3; decimals = 3;
+    } else if (ns < 1000000000) {
+        unit = "ms"; value = (double) ns / 1e6; decimals = 6;
+    }
+    snprintf(out, size, "%.*f", decimals, value);
+    /* trim trailing zeros and a dangling decimal point */
+    char *end = out + strlen(out) - 1;
+    while (end > out && *end == '0') *end-- = '\0';
+    if (*end == '.') *end = '\0';
+    strncat(out, unit, size - strlen(out) - 1);
+}
+
+/* render one ring record as a log line matching Go's log.LstdFlags|Lmicroseconds */
+static void append_log_record(log_text_t *t, const goserver_log_record_t *rec)
+{
+    char stamp[32], line[GOSERVER_LOG_TEXT_LEN + GOSERVER_LOG_REMOTE_LEN + 96];
+    time_t secs = (time_t) (rec->time_ns / 1000000000);
+    long usec = (long) ((rec->time_ns % 1000000000) / 1000);
+    struct tm tmv;
+#ifdef WIN32
+    localtime_s(&tmv, &secs);
+#else
+    localtime_r(&secs, &tmv);
+#endif
+    strftime(stamp, sizeof(stamp), "%Y/%m/%d %H:%M:%S", &tmv);
+
+    /* mark cut strings, where the line would have continued */
+    const char *cut = (rec->flags & GOSERVER_LOG_FLAG_TRUNCATED) ? "..." : "";
+    int n;
+    if (rec->kind == GOSERVER_LOG_KIND_ACCESS) {
+        char dur[32];
+        format_duration(rec->duration_ns, dur, sizeof(dur));
+        n = snprintf(line, sizeof(line), "%s.%06ld %s %s%s %s %s\n",
+                     stamp, usec, rec->method, rec->text, cut, rec->remote, dur);
+    } else {
+        n = snprintf(line, sizeof(line), "%s.%06ld %s%s\n", stamp, usec, rec->text, cut);
+    }
+    if (n > 0) log_text_append(t, line, (size_t) n < sizeof(line) ? (size_t) n : sizeof(line) - 1);
+}
+
+static void call_log_callback(bg_log_handler_t *h, const char *text)
+{
+    // Create R string from the log message
+    SEXP log_msg = PROTECT(mkString(text));
+    SEXP what = PROTECT(lang4(h->callback, h->self, log_msg, h->user));
+    
+    // Use tryCatch-like mechanism to handle errors in the callback
+    SEXP result = R_tryEval(what, R_GlobalEnv, NULL);
+    if (result == NULL) {
+        // Error occurred in callback - just ignore it to prevent recursive errors
+        // We could log this to stderr, but that would defeat the purpose
+        // of eliminating stderr usage for CRAN compliance
+    }
+    
+    UNPROTECT(2);
+}
+
+/* monotonic clock in milliseconds */
+static double now_ms(void)
+{
+#ifdef WIN32
+    return (double) GetTickCount64();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+#endif
+}
+
+/* drain the shared log ring into text; returns non-zero once the producer
+   has closed the ring or the pipe is closed */
+static int drain_log_ring(bg_log_handler_t *h, log_text_t *text)
+{
+    goserver_log_ring_t *ring = h->ring;
+    goserver_log_record_t *rec;
+    int pipe_closed = 0;
+    /* checked before draining, so a closed ring is emptied in this pass */
+    int ring_closed = goserver_log_ring_closed(ring);
+
+#ifndef WIN32
+    /* consume the doorbell; the worker thread does this on Windows */
+    char doorbell[256];
+    if (read(h->fd, doorbell, sizeof(doorbell)) <= 0)
+        pipe_closed = 1;
+#endif
+
+    do {
+        while ((rec = goserver_log_ring_peek(ring)) != NULL) {
+            append_log_record(text, rec);
+            goserver_log_ring_release(ring);
+        }
+        uint64_t dropped = goserver_log_ring_take_dropped(ring);
+        if (dropped > 0) {
+            char note[96];
+            int n = snprintf(note, sizeof(note), "[goserveR] %llu log records dropped (log ring full)\n",
+                             (unsigned long long) dropped);
+            if (n > 0) log_text_append(text, note, (size_t) n);
+        }
+        uint64_t truncated = goserver_log_ring_take_truncated(ring);
+        if (truncated > 0) {
+            char note[128];
+            int n = snprintf(note, sizeof(note),
+                             "[goserveR] %llu log records truncated to %d bytes (log ring)\n",
+                             (unsigned long long) truncated, GOSERVER_LOG_TEXT_LEN - 1);
+            if (n > 0) log_text_append(text, note, (size_t) n);
+        }
+    } while (!ring_closed && goserver_log_ring_sleep(ring));
+
+    return pipe_closed || ring_closed;
+}
+
+/* read everything currently available into the pending buffer;
+   returns non-zero once the pipe or the log ring is closed */
+static int read_available(bg_log_handler_t *h)
+{
+    log_text_t *pending = &h->pending;
+    int closed = 0;
+
+    if (h->ring)
+        return drain_log_ring(h, pending);
+
+#ifndef WIN32
+    char buffer[LOG_READ_CHUNK];
+    size_t total = 0;
+    struct pollfd pfd = { h->fd, POLLIN, 0 };
+    do {
+        ssize_t n = read(h->fd, buffer, sizeof(buffer));
+        if (n <= 0) {
+            closed = 1;
+            break;
+        }
+        log_text_append(pending, buffer, (size_t) n);
+        total += (size_t) n;
+    } while (total < 16 * LOG_READ_CHUNK && poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN));
+#else
+    bg_log_message_t *msg;
+
+    EnterCriticalSection(&h->msg_cs);
+    msg = h->msg_head;
+    h->msg_head = NULL;
+    h->msg_tail = NULL;
+    LeaveCriticalSection(&h->msg_cs);
+
+    while (msg) {
+        bg_log_message_t *next = msg->next;
+        log_text_append(pending, msg->text, strlen(msg->text));
+        free(msg->text);
+        free(msg);
+        msg = next;
+    }
+#endif
+    return closed;
+}
+
+/* number of complete lines in the pending buffer and where they end */
+static int pending_line_count(bg_log_handler_t *h, size_t *complete)
+{
+    int lines = 0;
+    *complete = 0;
+    for (size_t i = 0; i < h->pending.len; i++) {
+        if (h->pending.buf[i] == '\n') {
+            lines++;
+            *complete = i + 1;
+        }
+    }
+    return lines;
+}
+
+/* deliver pending complete lines (and the partial tail if flush_partial)
+   to the callback as one character vector */
+static void deliver_pending_lines(bg_log_handler_t *h, int flush_partial)
+{
+    size_t complete;
+    int lines = pending_line_count(h, &complete);
+
+    /* a runaway line without newline is delivered as-is */
+    if (flush_partial || h->pending.len - complete > LOG_MAX_PARTIAL) {
+        if (h->pending.len > complete) lines++;
+        complete = h->pending.len;
+    }
+    if (lines == 0) {
+        h->pending_since = 0;
+        return;
+    }
+
+    SEXP vec = PROTECT(allocVector(STRSXP, lines));
+    size_t start = 0;
+    int i = 0;
+    for (size_t pos = 0; pos < complete && i < lines; pos++) {
+        if (h->pending.buf[pos] == '\n' || pos == complete - 1) {
+            size_t end = (h->pending.buf[pos] == '\n') ? pos : pos + 1;
+            SET_STRING_ELT(vec, i++, mkCharLen(h->pending.buf + start, (int) (end - start)));
+            start = pos + 1;
+        }
+    }
+
+    /* keep the partial line for the next read */
+    memmove(h->pending.buf, h->pending.buf + complete, h->pending.len - complete);
+    h->pending.len -= complete;
+    h->pending_since = 0;
+
+    SEXP what = PROTECT(lang4(h->callback, h->self, vec, h->user));
+    R_tryEval(what, R_GlobalEnv, NULL);
+    UNPROTECT(2);
+}
+
+/* has a batching handler collected enough to deliver? */
+static int batch_ready(bg_log_handler_t *h, int lines)
+{
+    if (lines == 0) return 0;
+    if (h->batch_lines > 0 && lines >= h->batch_lines) return 1;
+    if (h->batch_interval > 0)
+        return now_ms() - h->pending_since >= h->batch_interval;
+    /* no threshold configured: deliver everything available per wakeup */
+    return h->batch_lines == 0;
+}
+
+/* line-framed batch mode: reassemble lines and deliver them in bulk */
+static void run_batch_callback(bg_log_handler_t *h)
+{
+    size_t complete;
+    int closed = read_available(h);
+    int lines = pending_line_count(h, &complete);
+
+    if (lines > 0 && h->pending_since == 0)
+        h->pending_since = now_ms();
+
+#ifndef WIN32
+    if (closed && h->ih) {
+        removeInputHandler(&R_InputHandlers, h->ih);
+        h->ih = NULL;
+    }
+#endif
+
+    if (closed || batch_ready(h, lines))
+        deliver_pending_lines(h, closed);
+}
+
 /* process a log message by calling the callback in R */
 static void run_log_callback_(void *ptr)
 {
@@ -172,6 +463,28 @@ static void run_log_callback_(void *ptr)
     // Check if handler is still valid
     if (!h || h->fd < 0) return;
     
+    if (h->batch) {
+        run_batch_callback(h);
+        return;
+    }
+
+    if (h->ring) {
+        log_text_t text = { NULL, 0, 0 };
+        int closed = drain_log_ring(h, &text);
+#ifndef WIN32
+        if (closed && h->ih) {
+            removeInputHandler(&R_InputHandlers, h->ih);
+            h->ih = NULL;
+        }
+#else
+        (void) closed;
+#endif
+        if (text.buf && text.len > 0)
+            call_log_callback(h, text.buf);
+        free(text.buf);
+        return;
+    }
+    
     // Read available data from the pipe
     char buffer[4096];
     ssize_t bytes_read;
@@ -213,20 +526,7 @@ static void run_log_callback_(void *ptr)
     }
     
     buffer[bytes_read] = '\0';
-    
-    // Create R string from the log message
-    SEXP log_msg = PROTECT(mkString(buffer));
-    SEXP what = PROTECT(lang4(h->callback, h->self, log_msg, h->user));
-    
-    // Use tryCatch-like mechanism to handle errors in the callback
-    SEXP result = R_tryEval(what, R_GlobalEnv, NULL);
-    if (result == NULL) {
-        // Error occurred in callback - just ignore it to prevent recursive errors
-        // We could log this to stderr, but that would defeat the purpose
-        // of eliminating stderr usage for CRAN compliance
-    }
-    
-    UNPROTECT(2);
+    call_log_callback(h, buffer);
 }
 
 /* wrap the actual call with ToplevelExec */
@@ -242,6 +542,106 @@ static void run_log_callback(bg_log_handler_t *h)
 #undef run_log_callback
 #endif
 
+/* Lines held back for batch_interval must reach R even when no more data
+   arrives. While such handlers exist a timer flushes expired batches: on
+   Unix a hook on R_PolledEvents (called whenever the R event loop times
+   out) with R_wait_usec capped at the shortest interval, on Windows a
+   WM_TIMER on the message window at the shortest interval. */
+static int batch_timer_handlers;
+#ifndef WIN32
+static void (*saved_polled_events)(void);
+static int saved_wait_usec;
+#else
+#define BATCH_TIMER_ID 1
+static int batch_timer_ms;
+#endif
+
+static void flush_expired_batch_(void *data)
+{
+    deliver_pending_lines((bg_log_handler_t*) data, 0);
+}
+
+static void flush_expired_batches(void)
+{
+    /* deliver one handler at a time; the list may change in the callback */
+    for (int round = 0; round < 64 && !in_process; round++) {
+        bg_log_handler_t *h, *expired = NULL;
+        double now = now_ms();
+
+        LOCK_LOG_HANDLERS();
+        for (h = log_handlers; h; h = h->next) {
+            if (h->batch && h->batch_interval > 0 && h->pending_since > 0 &&
+                now - h->pending_since >= h->batch_interval) {
+                expired = h;
+                break;
+            }
+        }
+        UNLOCK_LOG_HANDLERS();
+
+        if (!expired) break;
+        in_process = 1;
+        R_ToplevelExec(flush_expired_batch_, expired);
+        in_process = 0;
+    }
+}
+
+#ifndef WIN32
+static void batch_polled_events(void)
+{
+    flush_expired_batches();
+    if (saved_polled_events) saved_polled_events();
+}
+#endif
+
+static void batch_timer_add(int interval_ms)
+{
+#ifndef WIN32
+    if (batch_timer_handlers++ == 0) {
+        saved_polled_events = R_PolledEvents;
+        saved_wait_usec = R_wait_usec;
+        R_PolledEvents = batch_polled_events;
+    }
+    if (R_wait_usec <= 0 || R_wait_usec > interval_ms * 1000)
+        R_wait_usec = interval_ms * 1000;
+#else
+    /* setting the same timer id again replaces its interval */
+    if (batch_timer_handlers++ == 0 || interval_ms < batch_timer_ms) {
+        batch_timer_ms = interval_ms;
+        SetTimer(message_window, BATCH_TIMER_ID, (UINT) interval_ms, NULL);
+    }
+#endif
+}
+
+static void batch_timer_remove(void)
+{
+#ifndef WIN32
+    if (--batch_timer_handlers == 0 && R_PolledEvents == batch_polled_events) {
+        R_PolledEvents = saved_polled_events;
+        R_wait_usec = saved_wait_usec;
+    }
+#else
+    if (--batch_timer_handlers == 0) {
+        KillTimer(message_window, BATCH_TIMER_ID);
+        batch_timer_ms = 0;
+    }
+#endif
+}
+
+/* switch a handler to line-framed batch delivery */
+static void set_log_batch(bg_log_handler_t *h, int batch, int lines, int interval_ms)
+{
+    if (h->batch && h->batch_interval > 0)
+        batch_timer_remove();
+    h->batch = batch;
+    h->batch_lines = lines > 0 ? lines : 0;
+    h->batch_interval = interval_ms > 0 ? interval_ms : 0;
+    /* a line threshold alone could hold lines forever on a quiet server */
+    if (h->batch_lines > 0 && h->batch_interval == 0)
+        h->batch_interval = 1000;
+    if (h->batch && h->batch_interval > 0)
+        batch_timer_add(h->batch_interval);
+}
+
 #ifndef WIN32
 static void log_input_handler(void *data);
 #endif
@@ -254,6 +654,10 @@ static LRESULT CALLBACK BackgroundWindowProc(HWND hwnd, UINT uMsg, WPARAM wParam
         run_log_callback_main_thread(h);
         return 0;
     }
+    if (hwnd == message_window && uMsg == WM_TIMER && wParam == BATCH_TIMER_ID) {
+        flush_expired_batches();
+        return 0;
+    }
     return DefWindowProc(hwnd, uMsg, wParam, lParam);
 }
 
@@ -274,6 +678,14 @@ static DWORD WINAPI LogThreadProc(LPVOID lpParameter) {
             break;
         }
 
+        /* ring doorbell: the main thread drains the ring itself */
+        if (h->ring) {
+            if (!PostMessage(message_window, WM_LOG_CALLBACK, 0, (LPARAM) h)) {
+                break;
+            }
+            continue;
+        }
+
         buffer[bytes_read] = '\0';
 
         bg_log_message_t *msg = (bg_log_message_t*) calloc(1, sizeof(bg_log_message_t));
@@ -327,9 +739,12 @@ static void log_input_handler(void *data)
 #endif
 
 /* Register a log handler for a file descriptor */
-SEXP register_log_handler(SEXP s_fd, SEXP callback, SEXP user)
+SEXP register_log_handler(SEXP s_fd, SEXP callback, SEXP user, SEXP s_batch, SEXP s_batch_lines, SEXP s_batch_interval)
 {
     int fd = Rf_asInteger(s_fd);
+    int batch = Rf_asLogical(s_batch) == TRUE;
+    int batch_lines = Rf_asInteger(s_batch_lines);
+    int batch_interval = Rf_asInteger(s_batch_interval);
     bg_log_handler_t *h;
 
     if (needs_init)
@@ -355,6 +770,8 @@ SEXP register_log_handler(SEXP s_fd, SEXP callback, SEXP user)
         R_PreserveObject(user);
     R_PreserveObject(h->self = R_MakeExternalPtr(h, R_NilValue, R_NilValue));
     Rf_setAttrib(h->self, Rf_install("class"), mkString("LogHandler"));
+    set_log_batch(h, batch, batch_lines == NA_INTEGER ? 0 : batch_lines,
+                  batch_interval == NA_INTEGER ? 0 : batch_interval);
     
 #ifndef WIN32
     h->ih = addInputHandler(R_InputHandlers, fd, &log_input_handler, BackgroundActivity);
@@ -369,6 +786,30 @@ SEXP register_log_handler(SEXP s_fd, SEXP callback, SEXP user)
     return h->self;
 }
 
+/* Attach (or detach, with ring == NULL) the shared log ring of a server.
+   Must happen before the Go side starts producing. */
+void attach_log_ring(SEXP h_ptr, goserver_log_ring_t *ring)
+{
+    bg_log_handler_t *h;
+    if (TYPEOF(h_ptr) != EXTPTRSXP || !inherits(h_ptr, "LogHandler"))
+        return;
+    h = (bg_log_handler_t*) R_ExternalPtrAddr(h_ptr);
+    if (!h) return;
+    h->ring = ring;
+    /* the consumer starts idle, so the first record rings the doorbell */
+    if (ring) __atomic_store_n(&ring->waiting, 1, __ATOMIC_SEQ_CST);
+}
+
+/* Switch the handler behind a LogHandler pointer to batch delivery */
+void configure_log_batch(SEXP h_ptr, int lines, int interval_ms)
+{
+    bg_log_handler_t *h;
+    if (TYPEOF(h_ptr) != EXTPTRSXP || !inherits(h_ptr, "LogHandler"))
+        return;
+    h = (bg_log_handler_t*) R_ExternalPtrAddr(h_ptr);
+    if (h) set_log_batch(h, 1, lines, interval_ms);
+}
+
 /* Remove a log handler */
 SEXP remove_log_handler(SEXP h_ptr) {
     bg_log_handler_t *h;
@@ -377,6 +818,13 @@ SEXP remove_log_handler(SEXP h_ptr) {
     h = (bg_log_handler_t*) R_ExternalPtrAddr(h_ptr);
     if (!h) return ScalarLogical(0);
     
+    // Hand over whatever a batching handler is still holding back
+    if (h->batch && h->pending.len > 0 && !in_process) {
+        in_process = 1;
+        deliver_pending_lines(h, 1);
+        in_process = 0;
+    }
+    
     finalize_log_handler(h);
     free(h);
     R_ClearExternalPtr(h_ptr);
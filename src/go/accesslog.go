@@ -0,0 +1,168 @@
+//go:build ignore
+// +build ignore
+
+// Access log policy.
+//
+// Logging every request costs a formatted write plus a trip through the log
+// pipe into R. The policy below decides per request whether a line is worth
+// writing: failed (4xx, 5xx) and slow requests are always logged, successful
+// ones, including redirects and 304 revalidations, only at the "requests"
+// level and then optionally sampled. Suppressed
+// lines are counted so the volume that was skipped remains visible.
+
+package main
+
+import (
+	"io"
+	"log"
+	"math"
+	"net/http"
+	"sync/atomic"
+	"time"
+)
+
+// logLevel orders what gets logged; each level includes the ones before it
+type logLevel int
+
+const (
+	logErrors   logLevel = iota // failed and slow requests only
+	logAuth                     // plus auth grants
+	logRequests                 // plus every successful request
+)
+
+func parseLogLevel(s string) logLevel {
+	switch s {
+	case "errors":
+		return logErrors
+	case "auth":
+		return logAuth
+	}
+	return logRequests
+}
+
+// accessLog writes request log lines according to the server's log options
+type accessLog struct {
+	seq               atomic.Uint64
+	logged            atomic.Uint64
+	suppressedLevel   atomic.Uint64
+	suppressedSampled atomic.Uint64
+
+	logger      *log.Logger
+	ring        *ringLogWriter
+	level       logLevel
+	sampleEvery uint64        // log one in every sampleEvery successful requests
+	slow        time.Duration // always log requests at least this slow (0 = off)
+	records     *accessRing   // every request, whatever the policy; nil when off
+}
+
+func newAccessLog(logger *log.Logger, ring *ringLogWriter, opts serverOptions) *accessLog {
+	al := &accessLog{
+		logger:      logger,
+		ring:        ring,
+		level:       parseLogLevel(opts.str("log_level", "requests")),
+		sampleEvery: 1,
+		slow:        opts.duration("log_slow", 0),
+		records:     newAccessRing(opts),
+	}
+	if rate := opts.float("log_sample", 1); rate > 0 && rate < 1 {
+		al.sampleEvery = uint64(math.Round(1 / rate))
+	} else if rate <= 0 {
+		al.sampleEvery = 0
+	}
+	return al
+}
+
+// shouldLog applies the policy to a finished request and updates counters
+func (al *accessLog) shouldLog(status int, d time.Duration) bool {
+	if status >= 400 || (al.slow > 0 && d >= al.slow) {
+		return true
+	}
+	if al.level != logRequests {
+		al.suppressedLevel.Add(1)
+		return false
+	}
+	if al.sampleEvery != 1 {
+		if al.sampleEvery == 0 || al.seq.Add(1)%al.sampleEvery != 0 {
+			al.suppressedSampled.Add(1)
+			return false
+		}
+	}
+	return true
+}
+
+// request writes one access line
+func (al *accessLog) request(start time.Time, d time.Duration, r *http.Request) {
+	al.logged.Add(1)
+	if al.ring != nil {
+		al.ring.access(start, d, r.Method, r.RequestURI, r.RemoteAddr)
+		return
+	}
+	al.logger.Printf("%s %s %s %s", r.Method, r.RequestURI, r.RemoteAddr, d)
+}
+
+// auth writes an auth event line. Denials are failures and always logged,
+// grants only from the "auth" level up.
+func (al *accessLog) auth(granted bool, format string, args ...interface{}) {
+	if granted && al.level < logAuth {
+		al.suppressedLevel.Add(1)
+		return
+	}
+	al.logged.Add(1)
+	al.logger.Printf(format, args...)
+}
+
+// counters returns the log counters as name/value pairs
+func (al *accessLog) counters() []counter {
+	var records uint64
+	if al.records != nil {
+		records = al.records.next.Load()
+	}
+	return []counter{
+		{"log_lines", al.logged.Load()},
+		{"log_suppressed_level", al.suppressedLevel.Load()},
+		{"log_suppressed_sampled", al.suppressedSampled.Load()},
+		{"access_records", records},
+	}
+}
+
+// responseRecorder captures the response status and body size for logging
+// and metrics. It keeps ReadFrom so http.FileServer can still hand file
+// bodies to sendfile.
+type responseRecorder struct {
+	http.ResponseWriter
+	status int
+	bytes  int64
+}
+
+func (rr *responseRecorder) WriteHeader(code int) {
+	if rr.status == 0 {
+		rr.status = code
+	}
+	rr.ResponseWriter.WriteHeader(code)
+}
+
+func (rr *responseRecorder) Write(p []byte) (int, error) {
+	if rr.status == 0 {
+		rr.status = http.StatusOK
+	}
+	n, err := rr.ResponseWriter.Write(p)
+	rr.bytes += int64(n)
+	return n, err
+}
+
+func (rr *responseRecorder) ReadFrom(src io.Reader) (int64, error) {
+	if rr.status == 0 {
+		rr.status = http.StatusOK
+	}
+	n, err := io.Copy(rr.ResponseWriter, src)
+	rr.bytes += n
+	return n, err
+}
+
+// statusCode returns the status sent, treating an untouched response as 200
+func (rr *responseRecorder) statusCode() int {
+	if rr.status == 0 {
+		return http.StatusOK
+	}
+	return rr.status
+}
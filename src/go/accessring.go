@@ -0,0 +1,191 @@
+//go:build ignore
+// +build ignore
+
+// Access record ring.
+//
+// Every request served by a mount or a published object leaves a
+// structured record in a fixed-size ring, independently of the log level,
+// sampling and log handler, so getAccessLog() can pull recent traffic into
+// R on demand even from a silent server. Writers claim a slot with an atomic
+// counter and lock only that slot, so concurrent requests rarely contend.
+// API keys are recorded as a short HMAC under a random per-server secret,
+// never in clear, so key ids cannot be brute-forced from the records and
+// differ between servers.
+
+package main
+
+import (
+	"crypto/hmac"
+	"crypto/rand"
+	"crypto/sha256"
+	"encoding/binary"
+	"encoding/hex"
+	"fmt"
+	"net/http"
+	"strconv"
+	"strings"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+// accessRecord is one finished request
+type accessRecord struct {
+	seq      uint64    // 1-based; 0 marks an empty slot
+	time     time.Time // when the response finished
+	method   string
+	path     string
+	status   int
+	bytes    int64
+	duration time.Duration
+	remote   string
+	keyID    string
+}
+
+type accessSlot struct {
+	mu     sync.Mutex
+	record accessRecord
+}
+
+type accessRing struct {
+	next      atomic.Uint64
+	slots     []accessSlot
+	keySecret []byte // HMAC key for key ids, random per server
+}
+
+// newAccessRing returns nil when access_ring is 0
+func newAccessRing(opts serverOptions) *accessRing {
+	n := opts.int64("access_ring", 10000)
+	if n <= 0 {
+		return nil
+	}
+	secret := make([]byte, 32)
+	if _, err := rand.Read(secret); err != nil {
+		binary.BigEndian.PutUint64(secret, uint64(time.Now().UnixNano()))
+	}
+	return &accessRing{slots: make([]accessSlot, n), keySecret: secret}
+}
+
+// keyID identifies the credential of a request without revealing it
+func (ar *accessRing) keyID(r *http.Request) string {
+	if queryValue(r.URL.RawQuery, "signature") != "" {
+		return "signed"
+	}
+	key := r.Header.Get("X-API-Key")
+	if key == "" {
+		key = queryValue(r.URL.RawQuery, "api_key")
+	}
+	if key == "" {
+		return ""
+	}
+	mac := hmac.New(sha256.New, ar.keySecret)
+	mac.Write([]byte(key))
+	return hex.EncodeToString(mac.Sum(nil)[:8])
+}
+
+// middleware records every request to next, including those rejected by
+// auth or rate limiting
+func (ar *accessRing) middleware(next http.Handler) http.Handler {
+	if ar == nil {
+		return next
+	}
+	return http.HandlerFunc(func(w http.ResponseWriter, r *http.Request) {
+		start := time.Now()
+		rec := &responseRecorder{ResponseWriter: w}
+		next.ServeHTTP(rec, r)
+		ar.add(start, r, rec.statusCode(), rec.bytes)
+	})
+}
+
+func (ar *accessRing) add(start time.Time, r *http.Request, status int, bytes int64) {
+	// The full path without the query string, which may carry credentials
+	path := r.RequestURI
+	if i := strings.IndexByte(path, '?'); i >= 0 {
+		path = path[:i]
+	}
+	seq := ar.next.Add(1)
+	slot := &ar.slots[(seq-1)%uint64(len(ar.slots))]
+	slot.mu.Lock()
+	// Stamped under the slot lock, so a reader either sees the record or
+	// reads the slot before the stamp, i.e. after its cutoff (see format)
+	now := time.Now()
+	slot.record = accessRecord{
+		seq:      seq,
+		time:     now,
+		method:   r.Method,
+		path:     path,
+		status:   status,
+		bytes:    bytes,
+		duration: now.Sub(start),
+		remote:   clientHost(r.RemoteAddr),
+		keyID:    ar.keyID(r),
+	}
+	slot.mu.Unlock()
+}
+
+// tsvField keeps a value on one tab-separated field
+func tsvField(s string) string {
+	if strings.ContainsAny(s, "\t\n\r") {
+		return strings.NewReplacer("\t", " ", "\n", " ", "\r", " ").Replace(s)
+	}
+	return s
+}
+
+// format renders up to n of the latest records that finished after since,
+// oldest first, as a tab-separated table (n <= 0: all retained records).
+// Times are compared and reported in microseconds, so passing the last time
+// seen as since returns exactly the records finished since, however long
+// they ran.
+func (ar *accessRing) format(n int, since time.Time) string {
+	var b strings.Builder
+	b.WriteString("time\tmethod\tpath\tstatus\tbytes\tduration_ms\tremote\tkey_id\n")
+	if ar == nil {
+		return b.String()
+	}
+	// Records still being written during the walk are stamped after this
+	// cutoff. Leaving out everything from the cutoff on means the latest
+	// time returned is a safe since for the next call: nothing finishing
+	// at or before it can turn up later.
+	cutoff := time.Now().Truncate(time.Microsecond)
+	last := ar.next.Load()
+	size := uint64(len(ar.slots))
+	if n <= 0 || uint64(n) > size {
+		n = int(size)
+	}
+	// Walk back from the newest record, then emit in order
+	records := make([]accessRecord, 0, n)
+	for seq := last; seq > 0 && last-seq < size && len(records) < n; seq-- {
+		slot := &ar.slots[(seq-1)%size]
+		slot.mu.Lock()
+		rec := slot.record
+		slot.mu.Unlock()
+		if rec.seq != seq {
+			continue // overwritten, or claimed but not yet written
+		}
+		rec.time = rec.time.Truncate(time.Microsecond)
+		if !rec.time.After(since) || !rec.time.Before(cutoff) {
+			continue
+		}
+		records = append(records, rec)
+	}
+	for i := len(records) - 1; i >= 0; i-- {
+		rec := &records[i]
+		us := rec.time.UnixMicro()
+		fmt.Fprintf(&b, "%d.%06d\t", us/1e6, us%1e6)
+		b.WriteString(tsvField(rec.method))
+		b.WriteByte('\t')
+		b.WriteString(tsvField(rec.path))
+		b.WriteByte('\t')
+		b.WriteString(strconv.Itoa(rec.status))
+		b.WriteByte('\t')
+		b.WriteString(strconv.FormatInt(rec.bytes, 10))
+		b.WriteByte('\t')
+		b.WriteString(strconv.FormatFloat(float64(rec.duration)/float64(time.Millisecond), 'f', 3, 64))
+		b.WriteByte('\t')
+		b.WriteString(tsvField(rec.remote))
+		b.WriteByte('\t')
+		b.WriteString(tsvField(rec.keyID))
+		b.WriteByte('\n')
+	}
+	return b.String()
+}
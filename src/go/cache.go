@@ -0,0 +1,271 @@
+//go:build ignore
+// +build ignore
+
+// In-memory content cache.
+//
+// Small, hot files (index files such as .bai/.tbi/.csi/.fai, JSON, HTML) are
+// kept in memory under a byte budget with LRU eviction. Entries are validated
+// against the file's size and modification time, but at most once per
+// revalidation interval, so a hot hit costs no syscalls at all. Concurrent
+// misses for the same file are collapsed into a single read. Files too large
+// to cache (BAM, CRAM) are remembered and revalidated the same way, so they
+// go straight to disk without being opened by the cache first. The same LRU
+// also backs the cache of gzip-compressed variants (see compress.go) and of
+// directory listings (see listing.go).
+
+package main
+
+import (
+	"container/list"
+	"io"
+	"os"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+type cacheEntry struct {
+	key     string
+	path    string // file the entry was read from
+	size    int64  // size of that file
+	inode   uint64 // inode of that file, for regular files
+	etag    string // strong ETag of the data, from the same fstat
+	data    []byte
+	modTime time.Time
+	checked atomic.Int64 // UnixNano of the last validation
+	dir     *dirListing  // set for directory listings, whose path is a directory
+	elem    *list.Element
+}
+
+// cost is the number of bytes an entry counts against the cache budget
+func (e *cacheEntry) cost() int64 {
+	if e.dir != nil {
+		return e.dir.cost()
+	}
+	return int64(len(e.data))
+}
+
+// cacheLoad is an in-progress read that concurrent misses wait on
+type cacheLoad struct {
+	done  chan struct{}
+	entry *cacheEntry
+}
+
+type contentCache struct {
+	evictions atomic.Uint64
+
+	mu       sync.Mutex
+	entries  map[string]*cacheEntry
+	lru      *list.List // front = most recently used
+	loading  map[string]*cacheLoad
+	size     int64
+	budget   int64
+	maxEntry int64
+	validate time.Duration // < 0: entries never go stale
+
+	// Regular files over maxEntry, without data; bounded by maxTooLarge
+	tooLarge map[string]*cacheEntry
+}
+
+// maxTooLarge bounds the remembered uncacheable files; the set starts over
+// when it is full
+const maxTooLarge = 4096
+
+func newLRUCache(budget, maxEntry int64, validate time.Duration) *contentCache {
+	if budget <= 0 {
+		return nil
+	}
+	if maxEntry > budget {
+		maxEntry = budget
+	}
+	return &contentCache{
+		entries:  make(map[string]*cacheEntry),
+		lru:      list.New(),
+		loading:  make(map[string]*cacheLoad),
+		budget:   budget,
+		maxEntry: maxEntry,
+		validate: validate,
+	}
+}
+
+func newContentCache(opts serverOptions) *contentCache {
+	return newLRUCache(opts.int64("cache_bytes", 0), opts.int64("cache_max_file", 1<<20),
+		opts.duration("cache_validate", time.Second))
+}
+
+// get returns the cached contents of the file at name, loading it if it is
+// cacheable. hit reports whether it was served without touching the disk.
+// A nil entry means the file is not cacheable (missing, too large, not a
+// regular file) and should be served from disk.
+func (c *contentCache) get(name string) (entry *cacheEntry, hit bool) {
+	c.mu.Lock()
+	large := c.tooLarge[name]
+	c.mu.Unlock()
+	if large != nil {
+		if c.fresh(large) {
+			return nil, false
+		}
+		c.mu.Lock()
+		if c.tooLarge[name] == large {
+			delete(c.tooLarge, name)
+		}
+		c.mu.Unlock()
+	}
+	return c.getOrLoad(name, c.loadFile)
+}
+
+// getOrLoad looks up key and calls load on a miss; concurrent misses for
+// the same key wait for a single load
+func (c *contentCache) getOrLoad(key string, load func(string) *cacheEntry) (entry *cacheEntry, hit bool) {
+	c.mu.Lock()
+	if e := c.entries[key]; e != nil {
+		c.lru.MoveToFront(e.elem)
+		c.mu.Unlock()
+		if c.fresh(e) {
+			return e, true
+		}
+		c.mu.Lock()
+		c.remove(e)
+	}
+	if ld := c.loading[key]; ld != nil {
+		c.mu.Unlock()
+		<-ld.done
+		return ld.entry, false
+	}
+	ld := &cacheLoad{done: make(chan struct{})}
+	c.loading[key] = ld
+	c.mu.Unlock()
+
+	ld.entry = load(key)
+	if ld.entry != nil && ld.entry.cost() > c.maxEntry {
+		ld.entry = nil
+	}
+
+	c.mu.Lock()
+	delete(c.loading, key)
+	if ld.entry != nil {
+		c.insert(ld.entry)
+	}
+	c.mu.Unlock()
+	close(ld.done)
+	return ld.entry, false
+}
+
+// fresh revalidates an entry against the file once per validation interval
+func (c *contentCache) fresh(e *cacheEntry) bool {
+	if c.validate < 0 {
+		return true
+	}
+	now := time.Now().UnixNano()
+	if now-e.checked.Load() < int64(c.validate) {
+		return true
+	}
+	info, err := os.Stat(e.path)
+	if err != nil || info.Size() != e.size || !info.ModTime().Equal(e.modTime) {
+		return false
+	}
+	if e.dir != nil && !info.IsDir() || e.dir == nil && (!info.Mode().IsRegular() || fileInode(info) != e.inode) {
+		return false
+	}
+	e.checked.Store(now)
+	return true
+}
+
+func (c *contentCache) loadFile(name string) *cacheEntry {
+	f, err := os.Open(name)
+	if err != nil {
+		return nil
+	}
+	defer f.Close()
+	info, err := f.Stat()
+	if err != nil || !info.Mode().IsRegular() {
+		return nil
+	}
+	if info.Size() > c.maxEntry {
+		c.rememberTooLarge(name, info)
+		return nil
+	}
+	data, ok := readAll(f, info)
+	if !ok {
+		return nil
+	}
+	return newFileEntry(name, name, info, data)
+}
+
+// rememberTooLarge notes a regular file that is too large to cache
+func (c *contentCache) rememberTooLarge(name string, info os.FileInfo) {
+	e := &cacheEntry{key: name, path: name, size: info.Size(), inode: fileInode(info),
+		modTime: info.ModTime()}
+	e.checked.Store(time.Now().UnixNano())
+	c.mu.Lock()
+	if c.tooLarge == nil || len(c.tooLarge) >= maxTooLarge {
+		c.tooLarge = make(map[string]*cacheEntry)
+	}
+	c.tooLarge[name] = e
+	c.mu.Unlock()
+}
+
+// readAll reads an open regular file whose fstat is info
+func readAll(f *os.File, info os.FileInfo) ([]byte, bool) {
+	data := make([]byte, info.Size())
+	// The file shrank while reading; let the disk path deal with it
+	if _, err := io.ReadFull(f, data); err != nil {
+		return nil, false
+	}
+	return data, true
+}
+
+// newFileEntry caches data derived from the file at name, with the
+// validators of the fstat it was read under
+func newFileEntry(key, name string, info os.FileInfo, data []byte) *cacheEntry {
+	e := &cacheEntry{key: key, path: name, size: info.Size(), inode: fileInode(info),
+		etag: makeETag(info), data: data, modTime: info.ModTime()}
+	e.checked.Store(time.Now().UnixNano())
+	return e
+}
+
+// insert adds an entry and evicts least recently used ones over budget.
+// Called with c.mu held.
+func (c *contentCache) insert(e *cacheEntry) {
+	if old := c.entries[e.key]; old != nil {
+		c.remove(old)
+	}
+	e.elem = c.lru.PushFront(e)
+	c.entries[e.key] = e
+	c.size += e.cost()
+	for c.size > c.budget {
+		oldest := c.lru.Back().Value.(*cacheEntry)
+		c.remove(oldest)
+		c.evictions.Add(1)
+	}
+}
+
+// remove drops an entry if it is still cached. Called with c.mu held.
+func (c *contentCache) remove(e *cacheEntry) {
+	if c.entries[e.key] != e {
+		return
+	}
+	c.lru.Remove(e.elem)
+	delete(c.entries, e.key)
+	c.size -= e.cost()
+}
+
+// drop removes an entry that its user found to be stale
+func (c *contentCache) drop(e *cacheEntry) {
+	c.mu.Lock()
+	c.remove(e)
+	c.mu.Unlock()
+}
+
+// counters returns the cache counters as name/value pairs, with names
+// starting with prefix
+func (c *contentCache) counters(prefix string) []counter {
+	c.mu.Lock()
+	entries, size := len(c.entries), c.size
+	c.mu.Unlock()
+	return []counter{
+		{prefix + "_entries", uint64(entries)},
+		{prefix + "_bytes", uint64(size)},
+		{prefix + "_evictions", c.evictions.Load()},
+	}
+}
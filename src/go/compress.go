@@ -0,0 +1,278 @@
+//go:build ignore
+// +build ignore
+
+// Response compression.
+//
+// With compression enabled, requests that accept it are answered with a
+// precompressed sidecar (file.br, file.gz) when one exists next to the file.
+// Otherwise files of a whitelisted MIME type are gzip-compressed on the fly
+// and the result is kept in a bounded in-memory cache, revalidated against
+// the file like the content cache. Which sidecars exist and whether a file
+// is small enough to compress is probed once per validation interval, so a
+// hot file costs no syscalls here. Range requests are always answered from
+// the identity representation, so byte offsets keep referring to the
+// original file.
+
+package main
+
+import (
+	"bytes"
+	"compress/gzip"
+	"io"
+	"mime"
+	"net/http"
+	"os"
+	"path/filepath"
+	"strconv"
+	"strings"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+const sidecarProbeMaxEntries = 16384
+
+var defaultCompressTypes = []string{
+	"text/html", "text/plain", "text/css", "text/csv", "text/javascript",
+	"text/tab-separated-values", "text/xml", "application/javascript",
+	"application/json", "application/xml", "image/svg+xml",
+}
+
+type compressor struct {
+	sidecars atomic.Uint64
+	gzipped  atomic.Uint64
+
+	types   map[string]bool
+	minSize int64
+	maxSize int64
+	cache   *contentCache // gzip variants; nil disables on-the-fly gzip
+
+	mu       sync.RWMutex
+	probes   map[string]sidecarProbe
+	validate time.Duration
+}
+
+// sidecarProbe is what was found at and next to a file path
+type sidecarProbe struct {
+	checked int64 // UnixNano
+	regular bool
+	size    int64
+	br, gz  bool // file.br, file.gz exist
+}
+
+func newCompressor(opts serverOptions) *compressor {
+	if !opts.bool("compress", false) {
+		return nil
+	}
+	types := defaultCompressTypes
+	if list := opts.str("compress_types", ""); list != "" {
+		types = strings.Split(list, ",")
+	}
+	c := &compressor{
+		types:    make(map[string]bool, len(types)),
+		minSize:  opts.int64("compress_min_size", 1024),
+		maxSize:  opts.int64("compress_max_file", 8<<20),
+		probes:   make(map[string]sidecarProbe),
+		validate: opts.duration("cache_validate", time.Second),
+	}
+	c.cache = newLRUCache(opts.int64("compress_cache_bytes", 64<<20), c.maxSize, c.validate)
+	for _, t := range types {
+		c.types[strings.TrimSpace(t)] = true
+	}
+	return c
+}
+
+// acceptsEncoding reports whether an Accept-Encoding header allows coding
+func acceptsEncoding(header, coding string) bool {
+	for _, part := range strings.Split(header, ",") {
+		part = strings.TrimSpace(part)
+		params := ""
+		if i := strings.IndexByte(part, ';'); i >= 0 {
+			part, params = strings.TrimSpace(part[:i]), part[i+1:]
+		}
+		if part != coding && part != "*" {
+			continue
+		}
+		params = strings.TrimSpace(params)
+		if strings.HasPrefix(params, "q=") {
+			if q, err := strconv.ParseFloat(params[2:], 64); err == nil && q == 0 {
+				return false
+			}
+		}
+		return true
+	}
+	return false
+}
+
+// serve answers r with a compressed representation of the file at name if
+// possible, and reports whether it did. With etags, the representation gets
+// an ETag from the fstat of the bytes sent.
+func (c *compressor) serve(w http.ResponseWriter, r *http.Request, name string, etags bool) bool {
+	ctype := mime.TypeByExtension(filepath.Ext(name))
+	if ctype == "" {
+		return false
+	}
+	probe := c.probe(name)
+	if !probe.regular {
+		return false
+	}
+	mediaType := ctype
+	if i := strings.IndexByte(mediaType, ';'); i >= 0 {
+		mediaType = mediaType[:i]
+	}
+	gzipOK := c.cache != nil && c.types[mediaType] && probe.size >= c.minSize && probe.size <= c.maxSize
+	if !gzipOK && !probe.br && !probe.gz {
+		return false
+	}
+	// The response depends on Accept-Encoding even when it is not encoded
+	w.Header().Add("Vary", "Accept-Encoding")
+	accept := r.Header.Get("Accept-Encoding")
+	if accept == "" || r.Header.Get("Range") != "" {
+		return false
+	}
+
+	for _, coding := range []struct {
+		name, suffix string
+		present      bool
+	}{{"br", ".br", probe.br}, {"gzip", ".gz", probe.gz}} {
+		if !coding.present || !acceptsEncoding(accept, coding.name) {
+			continue
+		}
+		f, err := os.Open(name + coding.suffix)
+		if err != nil {
+			continue
+		}
+		sinfo, err := f.Stat()
+		if err != nil || !sinfo.Mode().IsRegular() {
+			f.Close()
+			continue
+		}
+		etag := ""
+		if etags {
+			etag = encodedETag(makeETag(sinfo), coding.name)
+		}
+		c.sidecars.Add(1)
+		serveEncoded(w, r, ctype, coding.name, etag, sinfo.ModTime(), sinfo.Size(), f)
+		f.Close()
+		return true
+	}
+
+	if !gzipOK || !acceptsEncoding(accept, "gzip") {
+		return false
+	}
+	entry, _ := c.cache.getOrLoad(name, c.gzipFile)
+	if entry == nil {
+		return false
+	}
+	etag := ""
+	if etags {
+		etag = entry.etag
+	}
+	c.gzipped.Add(1)
+	serveEncoded(w, r, ctype, "gzip", etag, entry.modTime, int64(len(entry.data)),
+		bytes.NewReader(entry.data))
+	return true
+}
+
+// probe returns what exists at and next to name, statting at most once per
+// validation interval
+func (c *compressor) probe(name string) sidecarProbe {
+	now := time.Now().UnixNano()
+	c.mu.RLock()
+	p, ok := c.probes[name]
+	c.mu.RUnlock()
+	if ok && now-p.checked < int64(c.validate) {
+		return p
+	}
+
+	p = sidecarProbe{checked: now}
+	if info, err := os.Stat(name); err == nil && info.Mode().IsRegular() {
+		p.regular, p.size = true, info.Size()
+		p.br = isRegularFile(name + ".br")
+		p.gz = isRegularFile(name + ".gz")
+	}
+	c.mu.Lock()
+	if len(c.probes) >= sidecarProbeMaxEntries {
+		c.probes = make(map[string]sidecarProbe)
+	}
+	c.probes[name] = p
+	c.mu.Unlock()
+	return p
+}
+
+func isRegularFile(name string) bool {
+	info, err := os.Stat(name)
+	return err == nil && info.Mode().IsRegular()
+}
+
+// gzipFile compresses the file at name into a cache entry
+func (c *compressor) gzipFile(name string) *cacheEntry {
+	f, err := os.Open(name)
+	if err != nil {
+		return nil
+	}
+	defer f.Close()
+	finfo, err := f.Stat()
+	if err != nil || !finfo.Mode().IsRegular() || finfo.Size() < c.minSize || finfo.Size() > c.maxSize {
+		return nil
+	}
+	data, ok := readAll(f, finfo)
+	if !ok {
+		return nil
+	}
+	var buf bytes.Buffer
+	zw, _ := gzip.NewWriterLevel(&buf, gzip.DefaultCompression)
+	if _, err := zw.Write(data); err != nil || zw.Close() != nil {
+		return nil
+	}
+	entry := newFileEntry(name, name, finfo, buf.Bytes())
+	entry.etag = encodedETag(entry.etag, "gzip")
+	return entry
+}
+
+// serveEncoded writes an encoded representation. http.ServeContent handles
+// conditional requests; the Content-Length it omits for encoded bodies is
+// set here since no range is ever applied.
+func serveEncoded(w http.ResponseWriter, r *http.Request, ctype, coding, etag string, modTime time.Time, size int64, content io.ReadSeeker) {
+	h := w.Header()
+	h.Set("Content-Type", ctype)
+	h.Set("Content-Encoding", coding)
+	if etag != "" {
+		h.Set("ETag", etag)
+	}
+	h.Set("Content-Length", strconv.FormatInt(size, 10))
+	http.ServeContent(encodedWriter{w}, r, "", modTime, content)
+}
+
+// encodedWriter removes the body headers set by serveEncoded when
+// http.ServeContent answers without the body, e.g. 304 or a 412 from a
+// failed If-Match, so the client does not wait for bytes that never come
+type encodedWriter struct {
+	http.ResponseWriter
+}
+
+func (w encodedWriter) WriteHeader(code int) {
+	if code != http.StatusOK {
+		h := w.Header()
+		h.Del("Content-Length")
+		h.Del("Content-Encoding")
+	}
+	w.ResponseWriter.WriteHeader(code)
+}
+
+// ReadFrom keeps sidecar bodies on the sendfile path
+func (w encodedWriter) ReadFrom(src io.Reader) (int64, error) {
+	return io.Copy(w.ResponseWriter, src)
+}
+
+// counters returns the compression counters as name/value pairs
+func (c *compressor) counters() []counter {
+	counters := []counter{
+		{"compress_sidecar", c.sidecars.Load()},
+		{"compress_gzip", c.gzipped.Load()},
+	}
+	if c.cache != nil {
+		counters = append(counters, c.cache.counters("compress_cache")...)
+	}
+	return counters
+}
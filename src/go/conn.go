@@ -0,0 +1,268 @@
+//go:build ignore
+// +build ignore
+
+// Connection management.
+//
+// The server accepts connections through limitListener, which refuses
+// connections over the global or per-client cap by closing them right away,
+// applies socket options, and tracks open connections. Connections that hit
+// one of the http.Server timeouts are counted when the read or write fails.
+//
+// With listeners = N the server opens N sockets on the same address with
+// SO_REUSEPORT, each with its own accept loop, and the kernel spreads new
+// connections across them. SO_REUSEPORT also lets other processes bind the
+// same address, so several R sessions can share one port.
+
+package main
+
+/*
+#ifndef _WIN32
+#include <sys/socket.h>
+#endif
+#ifdef SO_REUSEPORT
+#define GOSERVER_HAVE_REUSEPORT 1
+static int goserver_reuseport(int fd) {
+    int on = 1;
+    return setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+}
+#else
+#define GOSERVER_HAVE_REUSEPORT 0
+static int goserver_reuseport(int fd) {
+    return -1;
+}
+#endif
+*/
+import "C"
+import (
+	"context"
+	"errors"
+	"fmt"
+	"io"
+	"net"
+	"sync"
+	"sync/atomic"
+	"syscall"
+	"time"
+)
+
+type connLimits struct {
+	accepted       atomic.Uint64
+	rejectedGlobal atomic.Uint64
+	rejectedPerIP  atomic.Uint64
+	timeouts       atomic.Uint64
+	active         atomic.Int64
+
+	maxConns   int64 // 0 = unlimited
+	maxPerIP   int   // 0 = unlimited
+	sendBuffer int   // SO_SNDBUF in bytes, 0 = system default
+
+	mu    sync.Mutex
+	perIP map[string]int
+}
+
+func newConnLimits(opts serverOptions) *connLimits {
+	return &connLimits{
+		maxConns:   opts.int64("max_connections", 0),
+		maxPerIP:   int(opts.int64("max_connections_per_ip", 0)),
+		sendBuffer: int(opts.int64("send_buffer", 0)),
+		perIP:      make(map[string]int),
+	}
+}
+
+// admit applies the connection caps and socket options to a new
+// connection. It returns nil if the connection must be refused.
+func (l *connLimits) admit(c net.Conn) net.Conn {
+	if n := l.active.Add(1); l.maxConns > 0 && n > l.maxConns {
+		l.active.Add(-1)
+		l.rejectedGlobal.Add(1)
+		return nil
+	}
+	host := ""
+	if l.maxPerIP > 0 {
+		host = clientHost(c.RemoteAddr().String())
+		l.mu.Lock()
+		if l.perIP[host] >= l.maxPerIP {
+			l.mu.Unlock()
+			l.active.Add(-1)
+			l.rejectedPerIP.Add(1)
+			return nil
+		}
+		l.perIP[host]++
+		l.mu.Unlock()
+	}
+	if tcp, ok := c.(*net.TCPConn); ok && l.sendBuffer > 0 {
+		tcp.SetWriteBuffer(l.sendBuffer)
+	}
+	l.accepted.Add(1)
+	return &trackedConn{Conn: c, limits: l, host: host}
+}
+
+func (l *connLimits) release(host string) {
+	l.active.Add(-1)
+	if l.maxPerIP > 0 {
+		l.mu.Lock()
+		if l.perIP[host]--; l.perIP[host] <= 0 {
+			delete(l.perIP, host)
+		}
+		l.mu.Unlock()
+	}
+}
+
+// counters returns the connection counters as name/value pairs
+func (l *connLimits) counters() []counter {
+	return []counter{
+		{"conn_active", uint64(l.active.Load())},
+		{"conn_accepted", l.accepted.Load()},
+		{"conn_rejected_global", l.rejectedGlobal.Load()},
+		{"conn_rejected_per_ip", l.rejectedPerIP.Load()},
+		{"conn_timeouts", l.timeouts.Load()},
+	}
+}
+
+// listen opens the server's listening sockets
+func listen(addr string, opts serverOptions, limits *connLimits) ([]net.Listener, error) {
+	// KeepAlive < 0 disables TCP keepalive probes
+	keepAlive := opts.duration("tcp_keepalive", 15*time.Second)
+	if keepAlive == 0 {
+		keepAlive = -1
+	}
+	n := int(opts.int64("listeners", 1))
+	if n < 1 {
+		n = 1
+	}
+	lc := net.ListenConfig{KeepAlive: keepAlive}
+	if opts.bool("reuse_port", n > 1) {
+		if C.GOSERVER_HAVE_REUSEPORT == 0 {
+			return nil, errors.New("SO_REUSEPORT is not supported on this platform")
+		}
+		lc.Control = func(network, address string, c syscall.RawConn) error {
+			var err error
+			if cerr := c.Control(func(fd uintptr) {
+				if C.goserver_reuseport(C.int(fd)) != 0 {
+					err = fmt.Errorf("setting SO_REUSEPORT on %s: failed", address)
+				}
+			}); cerr != nil {
+				return cerr
+			}
+			return err
+		}
+	}
+	listeners := make([]net.Listener, 0, n)
+	for i := 0; i < n; i++ {
+		// Later sockets bind the port the first one got, so ":0" works
+		if i == 1 {
+			addr = listeners[0].Addr().String()
+		}
+		ln, err := lc.Listen(context.Background(), "tcp", addr)
+		if err != nil {
+			for _, l := range listeners {
+				l.Close()
+			}
+			return nil, err
+		}
+		listeners = append(listeners, &limitListener{Listener: ln, limits: limits})
+	}
+	return listeners, nil
+}
+
+type limitListener struct {
+	net.Listener
+	limits *connLimits
+}
+
+func (ln *limitListener) Accept() (net.Conn, error) {
+	for {
+		c, err := ln.Listener.Accept()
+		if err != nil {
+			return nil, err
+		}
+		if tracked := ln.limits.admit(c); tracked != nil {
+			return tracked, nil
+		}
+		c.Close()
+	}
+}
+
+// net/http cancels pending reads by setting a deadline in the distant past;
+// timeouts from such deadlines are not counted
+var deadlineFloor = time.Date(2000, 1, 1, 0, 0, 0, 0, time.UTC).UnixNano()
+
+// trackedConn releases its slot when closed and counts timeouts
+type trackedConn struct {
+	net.Conn
+	readDeadline  atomic.Int64 // UnixNano
+	writeDeadline atomic.Int64
+	limits        *connLimits
+	host          string
+	closed        atomic.Bool
+	timedOut      atomic.Bool
+}
+
+func (c *trackedConn) observe(err error, deadline *atomic.Int64) {
+	if ne, ok := err.(net.Error); ok && ne.Timeout() && deadline.Load() > deadlineFloor &&
+		c.timedOut.CompareAndSwap(false, true) {
+		c.limits.timeouts.Add(1)
+	}
+}
+
+func deadlineNanos(t time.Time) int64 {
+	if t.IsZero() {
+		return 0
+	}
+	return t.UnixNano()
+}
+
+func (c *trackedConn) SetDeadline(t time.Time) error {
+	c.readDeadline.Store(deadlineNanos(t))
+	c.writeDeadline.Store(deadlineNanos(t))
+	return c.Conn.SetDeadline(t)
+}
+
+func (c *trackedConn) SetReadDeadline(t time.Time) error {
+	c.readDeadline.Store(deadlineNanos(t))
+	return c.Conn.SetReadDeadline(t)
+}
+
+func (c *trackedConn) SetWriteDeadline(t time.Time) error {
+	c.writeDeadline.Store(deadlineNanos(t))
+	return c.Conn.SetWriteDeadline(t)
+}
+
+func (c *trackedConn) Read(b []byte) (int, error) {
+	n, err := c.Conn.Read(b)
+	if err != nil {
+		c.observe(err, &c.readDeadline)
+	}
+	return n, err
+}
+
+func (c *trackedConn) Write(b []byte) (int, error) {
+	n, err := c.Conn.Write(b)
+	if err != nil {
+		c.observe(err, &c.writeDeadline)
+	}
+	return n, err
+}
+
+// ReadFrom keeps the sendfile path of *net.TCPConn available to net/http
+func (c *trackedConn) ReadFrom(r io.Reader) (int64, error) {
+	var n int64
+	var err error
+	if rf, ok := c.Conn.(io.ReaderFrom); ok {
+		n, err = rf.ReadFrom(r)
+	} else {
+		n, err = io.Copy(c.Conn, r)
+	}
+	if err != nil {
+		c.observe(err, &c.writeDeadline)
+	}
+	return n, err
+}
+
+func (c *trackedConn) Close() error {
+	err := c.Conn.Close()
+	if c.closed.CompareAndSwap(false, true) {
+		c.limits.release(c.host)
+	}
+	return err
+}
@@ -0,0 +1,56 @@
+//go:build ignore
+// +build ignore
+
+// Lifecycle events.
+//
+// The server reports its state over an event pipe, one line per event:
+// "ready <addr>" once all listening sockets are bound (with the actual port,
+// so ":0" addresses work), "error <message>" when the server cannot start or
+// stops serving on an error, and "stopped" once shutdown is complete. The C
+// side waits for the first event before runServer() returns and leaves the
+// rest to an optional R callback.
+
+package main
+
+import (
+	"os"
+	"strings"
+	"sync"
+)
+
+type serverEvents struct {
+	mu sync.Mutex
+	f  *os.File // nil: events are not reported
+}
+
+// newServerEvents takes ownership of the write end of the event pipe
+func newServerEvents(fd uintptr, enabled bool) *serverEvents {
+	if !enabled {
+		return &serverEvents{}
+	}
+	return &serverEvents{f: os.NewFile(fd, "event-pipe")}
+}
+
+func (e *serverEvents) send(event, detail string) {
+	e.mu.Lock()
+	defer e.mu.Unlock()
+	if e.f == nil {
+		return
+	}
+	line := event
+	if detail != "" {
+		line += " " + strings.NewReplacer("\r", " ", "\n", " ").Replace(detail)
+	}
+	e.f.Write([]byte(line + "\n"))
+}
+
+// close sends the final "stopped" event and closes the pipe
+func (e *serverEvents) close() {
+	e.send("stopped", "")
+	e.mu.Lock()
+	defer e.mu.Unlock()
+	if e.f != nil {
+		e.f.Close()
+		e.f = nil
+	}
+}
@@ -1,3 +1,3 @@
 module github.com/sounkou-bioinfo/goServeR/src/go
 
-go 1.17
+go 1.19
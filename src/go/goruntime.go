@@ -0,0 +1,153 @@
+//go:build ignore
+// +build ignore
+
+// Go runtime controls.
+//
+// The Go runtime shares the process with R. SetRuntime caps the threads
+// running Go code (GOMAXPROCS), the GC target (GOGC) and the soft memory
+// limit (GOMEMLIMIT) so the servers of a session can be kept out of the way
+// of the analysis running next to them, and RuntimeStats reports what the
+// runtime is using.
+
+package main
+
+/*
+#include <stdlib.h>
+*/
+import "C"
+import (
+	"math"
+	"os"
+	"runtime"
+	"runtime/debug"
+	"sort"
+	"strconv"
+	"strings"
+	"sync/atomic"
+	"time"
+)
+
+// gcPercent mirrors the GC target. Reading it with SetGCPercent(-1) would
+// wait for a running collection, so it is tracked here instead, starting
+// from GOGC.
+var gcPercent atomic.Int64
+
+func init() {
+	percent := int64(100)
+	switch v := os.Getenv("GOGC"); v {
+	case "":
+	case "off":
+		percent = -1
+	default:
+		if n, err := strconv.ParseInt(v, 10, 64); err == nil {
+			percent = n
+		}
+	}
+	gcPercent.Store(percent)
+}
+
+// runtimeSettings renders the current limits as "name=value" lines
+func runtimeSettings(b *strings.Builder) {
+	writeStat(b, "maxprocs", float64(runtime.GOMAXPROCS(0)))
+	writeStat(b, "gc_percent", float64(gcPercent.Load()))
+	memLimit := debug.SetMemoryLimit(-1) // -1 only reads the limit
+	if memLimit == math.MaxInt64 {
+		writeStat(b, "memory_limit", math.Inf(1))
+	} else {
+		writeStat(b, "memory_limit", float64(memLimit))
+	}
+}
+
+func writeStat(b *strings.Builder, name string, v float64) {
+	b.WriteString(name)
+	b.WriteByte('=')
+	b.WriteString(strconv.FormatFloat(v, 'g', -1, 64))
+	b.WriteByte('\n')
+}
+
+// SetRuntime applies the maxprocs, gc_percent and memory_limit options
+// that are present ("off" for no memory limit) and returns the previous
+// settings as "name=value" lines. The caller frees the result.
+//
+//export SetRuntime
+func SetRuntime(cOptions *C.char) *C.char {
+	opts := parseServerOptions(C.GoString(cOptions))
+	var b strings.Builder
+	runtimeSettings(&b)
+	if n := opts.int64("maxprocs", 0); n > 0 {
+		runtime.GOMAXPROCS(int(n))
+	}
+	if _, ok := opts["gc_percent"]; ok {
+		percent := opts.int64("gc_percent", 100)
+		gcPercent.Store(percent)
+		debug.SetGCPercent(int(percent))
+	}
+	if limit := opts.str("memory_limit", ""); limit == "off" {
+		debug.SetMemoryLimit(math.MaxInt64)
+	} else if limit != "" {
+		debug.SetMemoryLimit(opts.int64("memory_limit", math.MaxInt64))
+	}
+	return C.CString(b.String())
+}
+
+// RuntimeStats returns the runtime settings, goroutines, heap, GC pause
+// quantiles over the last 256 collections and open file descriptors as
+// "name=value" lines. The caller frees the result.
+//
+//export RuntimeStats
+func RuntimeStats() *C.char {
+	var ms runtime.MemStats
+	runtime.ReadMemStats(&ms)
+
+	var b strings.Builder
+	runtimeSettings(&b)
+	writeStat(&b, "num_cpu", float64(runtime.NumCPU()))
+	writeStat(&b, "goroutines", float64(runtime.NumGoroutine()))
+	writeStat(&b, "heap_alloc", float64(ms.HeapAlloc))
+	writeStat(&b, "heap_inuse", float64(ms.HeapInuse))
+	writeStat(&b, "heap_idle", float64(ms.HeapIdle))
+	writeStat(&b, "heap_released", float64(ms.HeapReleased))
+	writeStat(&b, "sys", float64(ms.Sys))
+	writeStat(&b, "num_gc", float64(ms.NumGC))
+
+	// PauseNs is a circular buffer of the most recent pauses
+	n := int(ms.NumGC)
+	if n > len(ms.PauseNs) {
+		n = len(ms.PauseNs)
+	}
+	pauses := make([]float64, n)
+	for i := range pauses {
+		pauses[i] = float64(ms.PauseNs[(int(ms.NumGC)-1-i+len(ms.PauseNs))%len(ms.PauseNs)])
+	}
+	sort.Float64s(pauses)
+	pauseMs := func(q float64) float64 {
+		if n == 0 {
+			return 0
+		}
+		return pauses[int(math.Ceil(q*float64(n)))-1] / float64(time.Millisecond)
+	}
+	writeStat(&b, "gc_pause_p50_ms", pauseMs(0.5))
+	writeStat(&b, "gc_pause_p90_ms", pauseMs(0.9))
+	writeStat(&b, "gc_pause_p99_ms", pauseMs(0.99))
+	writeStat(&b, "gc_pause_max_ms", pauseMs(1))
+	writeStat(&b, "gc_pause_total_ms", float64(ms.PauseTotalNs)/float64(time.Millisecond))
+	writeStat(&b, "open_fds", openFDs())
+	return C.CString(b.String())
+}
+
+// openFDs counts the open file descriptors of the process, NaN where they
+// cannot be listed
+func openFDs() float64 {
+	for _, dir := range []string{"/proc/self/fd", "/dev/fd"} {
+		f, err := os.Open(dir)
+		if err != nil {
+			continue
+		}
+		names, err := f.Readdirnames(-1)
+		f.Close()
+		if err == nil {
+			return float64(len(names) - 1) // minus the one used for listing
+		}
+	}
+	return math.NaN()
+}
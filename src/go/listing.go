@@ -0,0 +1,207 @@
+//go:build ignore
+// +build ignore
+
+// Directory listings.
+//
+// Directory requests that http.FileServer would answer with a generated
+// listing are answered here instead. A listing is read and sorted once and
+// kept, pre-rendered, in an LRU cache (the same one cache.go implements) that
+// revalidates it against the directory's mtime once per validation interval;
+// since file sizes inside a directory can change without touching its mtime,
+// listings are also rebuilt after a maximum age. Besides the HTML page
+// http.FileServer produces, ?format=json&offset=&limit= returns one page of
+// name/size/mtime/type records, sliced straight out of the pre-encoded
+// records without building the full page.
+
+package main
+
+import (
+	"encoding/json"
+	"net/http"
+	"net/url"
+	"os"
+	"sort"
+	"strconv"
+	"strings"
+	"sync/atomic"
+	"time"
+)
+
+// dirListing is a pre-rendered directory listing
+type dirListing struct {
+	html     []byte
+	records  []byte // JSON records, each preceded by a comma
+	offsets  []int  // start of each record in records, plus the end
+	hasIndex bool   // the directory has an index.html, which is served instead
+	loaded   time.Time
+}
+
+func (d *dirListing) cost() int64 {
+	return int64(len(d.html) + len(d.records) + 8*len(d.offsets))
+}
+
+// page returns records [offset, offset+limit) as the inside of a JSON array
+func (d *dirListing) page(offset, limit int) (records []byte, count int) {
+	total := len(d.offsets) - 1
+	if offset > total {
+		offset = total
+	}
+	if limit < 0 || limit > total-offset {
+		limit = total - offset
+	}
+	if limit == 0 {
+		return nil, 0
+	}
+	return d.records[d.offsets[offset]+1 : d.offsets[offset+limit]], limit
+}
+
+type listingCache struct {
+	builds atomic.Uint64
+
+	cache  *contentCache // nil: listings are built on every request
+	maxAge time.Duration
+}
+
+func newListingCache(opts serverOptions) *listingCache {
+	budget := opts.int64("listing_cache_bytes", 32<<20)
+	return &listingCache{
+		cache:  newLRUCache(budget, budget, opts.duration("listing_validate", time.Second)),
+		maxAge: opts.duration("listing_max_age", 30*time.Second),
+	}
+}
+
+// get returns the listing of the directory at name, or nil if it is not a
+// readable directory
+func (l *listingCache) get(name string) *dirListing {
+	if l.cache == nil {
+		if e := l.load(name); e != nil {
+			return e.dir
+		}
+		return nil
+	}
+	e, _ := l.cache.getOrLoad(name, l.load)
+	if e != nil && l.maxAge > 0 && time.Since(e.dir.loaded) > l.maxAge {
+		l.cache.drop(e)
+		e, _ = l.cache.getOrLoad(name, l.load)
+	}
+	if e == nil {
+		return nil
+	}
+	return e.dir
+}
+
+var htmlReplacer = strings.NewReplacer("&", "&amp;", "<", "&lt;", ">", "&gt;", `"`, "&#34;", "'", "&#39;")
+
+// load reads and renders a directory listing
+func (l *listingCache) load(name string) *cacheEntry {
+	f, err := os.Open(name)
+	if err != nil {
+		return nil
+	}
+	defer f.Close()
+	info, err := f.Stat()
+	if err != nil || !info.IsDir() {
+		return nil
+	}
+	entries, err := f.ReadDir(-1)
+	if err != nil {
+		return nil
+	}
+	l.builds.Add(1)
+	sort.Slice(entries, func(i, j int) bool { return entries[i].Name() < entries[j].Name() })
+
+	d := &dirListing{offsets: make([]int, 0, len(entries)+1), loaded: time.Now()}
+	html := []byte("<!doctype html>\n<meta name=\"viewport\" content=\"width=device-width\">\n<pre>\n")
+	var records []byte
+	for _, entry := range entries {
+		info, err := entry.Info()
+		if err != nil {
+			continue // removed since ReadDir
+		}
+		entryName, kind := entry.Name(), "file"
+		switch {
+		case info.IsDir():
+			entryName, kind = entryName+"/", "dir"
+		case info.Mode()&os.ModeSymlink != 0:
+			kind = "link"
+		}
+		if entryName == "index.html" {
+			d.hasIndex = true
+		}
+
+		// Same markup as http.FileServer
+		link := url.URL{Path: entryName}
+		html = append(html, "<a href=\""...)
+		html = append(html, link.String()...)
+		html = append(html, "\">"...)
+		html = append(html, htmlReplacer.Replace(entryName)...)
+		html = append(html, "</a>\n"...)
+
+		quoted, _ := json.Marshal(entry.Name())
+		d.offsets = append(d.offsets, len(records))
+		records = append(records, `,{"name":`...)
+		records = append(records, quoted...)
+		records = append(records, `,"size":`...)
+		records = append(records, strconv.FormatInt(info.Size(), 10)...)
+		records = append(records, `,"mtime":`...)
+		records = append(records, strconv.FormatInt(info.ModTime().Unix(), 10)...)
+		records = append(records, `,"type":"`...)
+		records = append(records, kind...)
+		records = append(records, `"}`...)
+	}
+	d.offsets = append(d.offsets, len(records))
+	d.html = append(html, "</pre>\n"...)
+	d.records = records
+	e := &cacheEntry{key: name, path: name, size: info.Size(), modTime: info.ModTime(), dir: d}
+	e.checked.Store(time.Now().UnixNano())
+	return e
+}
+
+// serve writes the listing of a directory, as HTML or as one page of JSON
+func (d *dirListing) serve(w http.ResponseWriter, r *http.Request) {
+	q := r.URL.Query()
+	if q.Get("format") != "json" {
+		w.Header().Set("Content-Type", "text/html; charset=utf-8")
+		w.Header().Set("Content-Length", strconv.Itoa(len(d.html)))
+		if r.Method != http.MethodHead {
+			w.Write(d.html)
+		}
+		return
+	}
+	offset, _ := strconv.Atoi(q.Get("offset"))
+	if offset < 0 {
+		offset = 0
+	}
+	limit := -1
+	if v := q.Get("limit"); v != "" {
+		if n, err := strconv.Atoi(v); err == nil && n >= 0 {
+			limit = n
+		}
+	}
+	records, count := d.page(offset, limit)
+	total := len(d.offsets) - 1
+	if offset > total {
+		offset = total
+	}
+	quotedPath, _ := json.Marshal(r.URL.Path)
+	head := `{"path":` + string(quotedPath) + `,"total":` + strconv.Itoa(total) +
+		`,"offset":` + strconv.Itoa(offset) + `,"count":` + strconv.Itoa(count) + `,"entries":[`
+	const tail = "]}\n"
+	w.Header().Set("Content-Type", "application/json")
+	w.Header().Set("Content-Length", strconv.Itoa(len(head)+len(records)+len(tail)))
+	if r.Method == http.MethodHead {
+		return
+	}
+	w.Write([]byte(head))
+	w.Write(records)
+	w.Write([]byte(tail))
+}
+
+// counters returns the listing counters as name/value pairs
+func (l *listingCache) counters() []counter {
+	counters := []counter{{"listing_builds", l.builds.Load()}}
+	if l.cache != nil {
+		counters = append(counters, l.cache.counters("listing_cache")...)
+	}
+	return counters
+}
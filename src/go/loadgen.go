@@ -0,0 +1,293 @@
+//go:build ignore
+// +build ignore
+
+// Load generator for the benchmark suite in inst/bench.
+//
+// StartLoad drives a server with concurrent keep-alive clients for a fixed
+// time in the background and LoadResult collects throughput and latency
+// quantiles once it is done. It runs off the R thread so that R log handlers
+// keep draining the server's log pipe while the load runs. Latencies go into
+// the same log-linear histogram the per-mount metrics use.
+//
+// Modes:
+//   - "get": GET the URLs in turn
+//   - "random_range": random range_size ranges of the first URL
+//   - "sequential_range": each client streams the first URL in range_size
+//     ranges from a random start, wrapping at the end
+//
+// Protocols:
+//   - "auto": HTTP/2 where TLS negotiates it, HTTP/1.1 otherwise
+//   - "http1.1": HTTP/1.1 only, one connection per client
+//   - "h2": HTTP/2 over TLS only, all clients multiplexed on one connection;
+//     responses over another protocol count as errors
+
+package main
+
+/*
+#include <stdlib.h>
+*/
+import "C"
+import (
+	"crypto/tls"
+	"errors"
+	"fmt"
+	"io"
+	"math/rand"
+	"net/http"
+	"strconv"
+	"strings"
+	"sync"
+	"time"
+)
+
+type loadConfig struct {
+	urls        []string
+	mode        string
+	protocol    string
+	concurrency int
+	duration    time.Duration
+	rangeSize   int64
+	fileSize    int64 // 0: found with a HEAD request
+	apiKey      string
+}
+
+func parseLoadConfig(opts serverOptions) (*loadConfig, error) {
+	c := &loadConfig{
+		mode:        opts.str("mode", "get"),
+		protocol:    opts.str("protocol", "auto"),
+		concurrency: int(opts.int64("concurrency", 8)),
+		duration:    opts.duration("duration", 5*time.Second),
+		rangeSize:   opts.int64("range_size", 64<<10),
+		fileSize:    opts.int64("file_size", 0),
+		apiKey:      opts.str("api_key", ""),
+	}
+	for _, u := range strings.Split(opts.str("urls", ""), ",") {
+		if u = strings.TrimSpace(u); u != "" {
+			c.urls = append(c.urls, u)
+		}
+	}
+	switch {
+	case len(c.urls) == 0:
+		return nil, errors.New("no URLs given")
+	case c.mode != "get" && c.mode != "random_range" && c.mode != "sequential_range":
+		return nil, fmt.Errorf("unknown mode %q", c.mode)
+	case c.protocol != "auto" && c.protocol != "http1.1" && c.protocol != "h2":
+		return nil, fmt.Errorf("unknown protocol %q", c.protocol)
+	case c.concurrency < 1 || c.duration <= 0 || c.rangeSize < 1:
+		return nil, errors.New("concurrency, duration and range_size must be positive")
+	}
+	if c.protocol == "h2" {
+		for _, u := range c.urls {
+			if !strings.HasPrefix(u, "https://") {
+				return nil, fmt.Errorf("protocol h2 needs https URLs, got %q", u)
+			}
+		}
+	}
+	return c, nil
+}
+
+// loadWorker holds the results of one client
+type loadWorker struct {
+	requests, errors, bytes uint64
+	hist                    [histBuckets]uint64
+}
+
+type loadRun struct {
+	config *loadConfig
+	client *http.Client
+	done   chan struct{}
+	result string
+}
+
+var loadRuns = struct {
+	sync.Mutex
+	next int
+	runs map[int]*loadRun
+}{runs: make(map[int]*loadRun)}
+
+// StartLoad starts a load run described by newline-separated key=value
+// options and returns its id, or -1 with the error in *cError (to be freed
+// by the caller).
+//
+//export StartLoad
+func StartLoad(cOptions *C.char, cError **C.char) C.int {
+	config, err := parseLoadConfig(parseServerOptions(C.GoString(cOptions)))
+	if err != nil {
+		*cError = C.CString(err.Error())
+		return -1
+	}
+	transport := &http.Transport{
+		MaxIdleConnsPerHost: config.concurrency,
+		DisableCompression:  true,
+		// Benchmarks run against self-signed certificates
+		TLSClientConfig: &tls.Config{InsecureSkipVerify: true},
+		// A custom TLSClientConfig turns HTTP/2 off unless forced back on
+		ForceAttemptHTTP2: config.protocol != "http1.1",
+	}
+	if config.protocol == "http1.1" {
+		// A non-nil, empty TLSNextProto keeps ALPN from offering h2
+		transport.TLSNextProto = map[string]func(string, *tls.Conn) http.RoundTripper{}
+	}
+	run := &loadRun{config: config, client: &http.Client{Transport: transport}, done: make(chan struct{})}
+	if config.mode != "get" && config.fileSize == 0 {
+		if config.fileSize, err = run.headSize(config.urls[0]); err != nil {
+			*cError = C.CString(err.Error())
+			return -1
+		}
+	}
+	loadRuns.Lock()
+	loadRuns.next++
+	id := loadRuns.next
+	loadRuns.runs[id] = run
+	loadRuns.Unlock()
+	go run.run()
+	return C.int(id)
+}
+
+// LoadResult returns the results of a finished run as "name=value" lines
+// and forgets the run, "" for an unknown run, or NULL while it is still
+// running. The caller frees the result.
+//
+//export LoadResult
+func LoadResult(id C.int) *C.char {
+	loadRuns.Lock()
+	run := loadRuns.runs[int(id)]
+	loadRuns.Unlock()
+	if run == nil {
+		return C.CString("")
+	}
+	select {
+	case <-run.done:
+	default:
+		return nil
+	}
+	loadRuns.Lock()
+	delete(loadRuns.runs, int(id))
+	loadRuns.Unlock()
+	return C.CString(run.result)
+}
+
+func (run *loadRun) headSize(url string) (int64, error) {
+	req, err := http.NewRequest(http.MethodHead, url, nil)
+	if err != nil {
+		return 0, err
+	}
+	run.authorize(req)
+	resp, err := run.client.Do(req)
+	if err != nil {
+		return 0, err
+	}
+	resp.Body.Close()
+	if resp.StatusCode != http.StatusOK || resp.ContentLength <= 0 {
+		return 0, fmt.Errorf("HEAD %s: status %d, length %d", url, resp.StatusCode, resp.ContentLength)
+	}
+	return resp.ContentLength, nil
+}
+
+func (run *loadRun) authorize(req *http.Request) {
+	if run.config.apiKey != "" {
+		req.Header.Set("X-API-Key", run.config.apiKey)
+	}
+}
+
+func (run *loadRun) run() {
+	defer close(run.done)
+	c := run.config
+	workers := make([]loadWorker, c.concurrency)
+	start := time.Now()
+	deadline := start.Add(c.duration)
+	var wg sync.WaitGroup
+	for i := range workers {
+		wg.Add(1)
+		go func(i int) {
+			defer wg.Done()
+			run.work(&workers[i], rand.New(rand.NewSource(int64(i)+start.UnixNano())), i, deadline)
+		}(i)
+	}
+	wg.Wait()
+	elapsed := time.Since(start).Seconds()
+	run.client.CloseIdleConnections()
+
+	var total loadWorker
+	for i := range workers {
+		w := &workers[i]
+		total.requests += w.requests
+		total.errors += w.errors
+		total.bytes += w.bytes
+		for b, n := range w.hist {
+			total.hist[b] += n
+		}
+	}
+	var b strings.Builder
+	field := func(name string, v float64) {
+		b.WriteString(name)
+		b.WriteByte('=')
+		b.WriteString(strconv.FormatFloat(v, 'f', -1, 64))
+		b.WriteByte('\n')
+	}
+	field("requests", float64(total.requests))
+	field("errors", float64(total.errors))
+	field("bytes", float64(total.bytes))
+	field("seconds", elapsed)
+	field("requests_per_sec", float64(total.requests)/elapsed)
+	field("mb_per_sec", float64(total.bytes)/elapsed/1e6)
+	field("p50_ms", quantile(total.hist, total.requests, 0.5))
+	field("p90_ms", quantile(total.hist, total.requests, 0.9))
+	field("p99_ms", quantile(total.hist, total.requests, 0.99))
+	run.result = b.String()
+}
+
+// work issues requests from one client until the deadline
+func (run *loadRun) work(w *loadWorker, rng *rand.Rand, i int, deadline time.Time) {
+	c := run.config
+	var offset int64
+	if c.mode == "sequential_range" {
+		offset = rng.Int63n(c.fileSize) / c.rangeSize * c.rangeSize
+	}
+	for n := i; time.Now().Before(deadline); n++ {
+		url := c.urls[0]
+		if c.mode == "get" {
+			url = c.urls[n%len(c.urls)]
+		}
+		req, err := http.NewRequest(http.MethodGet, url, nil)
+		if err != nil {
+			w.errors++
+			return
+		}
+		switch c.mode {
+		case "random_range":
+			offset = 0
+			if c.fileSize > c.rangeSize {
+				offset = rng.Int63n(c.fileSize - c.rangeSize)
+			}
+			req.Header.Set("Range", fmt.Sprintf("bytes=%d-%d", offset, offset+c.rangeSize-1))
+		case "sequential_range":
+			if offset >= c.fileSize {
+				offset = 0
+			}
+			req.Header.Set("Range", fmt.Sprintf("bytes=%d-%d", offset, offset+c.rangeSize-1))
+			offset += c.rangeSize
+		}
+		run.authorize(req)
+
+		t := time.Now()
+		resp, err := run.client.Do(req)
+		if err == nil {
+			var copied int64
+			copied, err = io.Copy(io.Discard, resp.Body)
+			resp.Body.Close()
+			w.bytes += uint64(copied)
+			if err == nil && resp.StatusCode >= 300 {
+				err = errors.New(resp.Status)
+			}
+			if err == nil && c.protocol == "h2" && resp.ProtoMajor != 2 {
+				err = errors.New(resp.Proto)
+			}
+		}
+		w.hist[histBucket(time.Since(t))]++
+		w.requests++
+		if err != nil {
+			w.errors++
+		}
+	}
+}
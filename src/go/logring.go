@@ -0,0 +1,108 @@
+//go:build ignore
+// +build ignore
+
+// Shared-memory log transport.
+//
+// With log_transport = "ring" the server does not format log lines into the
+// log pipe. Instead it copies fixed-layout records into a ring allocated by
+// the C side (see src/logring.h) and writes a single doorbell byte to the log
+// pipe only when the R-side consumer is idle. The consumer drains all pending
+// records in one go, so a busy server costs one pipe wakeup per batch instead
+// of one write/read pair per line.
+
+package main
+
+/*
+#include <stdint.h>
+#include <string.h>
+#include "logring.h"
+
+// Returns non-zero if s was cut to fit
+static int goserver_copy_gostring(char* dst, size_t cap, _GoString_ s) {
+    size_t n = _GoStringLen(s);
+    int cut = n >= cap;
+    if (cut) n = cap - 1;
+    memcpy(dst, _GoStringPtr(s), n);
+    dst[n] = '\0';
+    return cut;
+}
+
+// Producer side of the ring. The Go caller serializes pushes, so there is a
+// single producer. Returns non-zero when the consumer needs a doorbell byte.
+static int goserver_log_ring_push(goserver_log_ring_t* ring, int32_t kind,
+                                  int64_t time_ns, int64_t duration_ns,
+                                  _GoString_ method, _GoString_ remote,
+                                  _GoString_ text) {
+    uint64_t head = ring->head;
+    uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    if (head - tail < GOSERVER_LOG_RING_SLOTS) {
+        goserver_log_record_t* rec = &ring->slots[head & (GOSERVER_LOG_RING_SLOTS - 1)];
+        rec->time_ns = time_ns;
+        rec->duration_ns = duration_ns;
+        rec->kind = kind;
+        int cut = goserver_copy_gostring(rec->method, sizeof(rec->method), method);
+        cut |= goserver_copy_gostring(rec->remote, sizeof(rec->remote), remote);
+        cut |= goserver_copy_gostring(rec->text, sizeof(rec->text), text);
+        rec->flags = cut ? GOSERVER_LOG_FLAG_TRUNCATED : 0;
+        if (cut) __atomic_fetch_add(&ring->truncated, 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&ring->head, head + 1, __ATOMIC_SEQ_CST);
+    } else {
+        // Never block the server on a slow consumer
+        __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+    }
+    return __atomic_exchange_n(&ring->waiting, 0, __ATOMIC_SEQ_CST);
+}
+
+static void goserver_log_ring_close(goserver_log_ring_t* ring) {
+    __atomic_store_n(&ring->closed, 1, __ATOMIC_SEQ_CST);
+}
+*/
+import "C"
+import (
+	"os"
+	"strings"
+	"sync"
+	"time"
+)
+
+// ringLogWriter publishes log records into the shared ring. It implements
+// io.Writer so it can back a log.Logger for free-form messages.
+type ringLogWriter struct {
+	mu       sync.Mutex
+	ring     *C.goserver_log_ring_t
+	doorbell *os.File
+}
+
+func newRingLogWriter(ring *C.goserver_log_ring_t, doorbell *os.File) *ringLogWriter {
+	return &ringLogWriter{ring: ring, doorbell: doorbell}
+}
+
+func (rw *ringLogWriter) push(kind C.int32_t, t time.Time, d time.Duration, method, remote, text string) {
+	rw.mu.Lock()
+	ring := C.goserver_log_ring_push(rw.ring, kind, C.int64_t(t.UnixNano()), C.int64_t(d),
+		method, remote, text) != 0
+	rw.mu.Unlock()
+	if ring {
+		_, _ = rw.doorbell.Write([]byte{1})
+	}
+}
+
+// Write stores one free-form message record. The logger using this writer
+// must not add its own timestamp; the consumer formats it from the record.
+func (rw *ringLogWriter) Write(p []byte) (int, error) {
+	rw.push(C.GOSERVER_LOG_KIND_MESSAGE, time.Now(), 0, "", "", strings.TrimRight(string(p), "\n"))
+	return len(p), nil
+}
+
+// access stores one access record
+func (rw *ringLogWriter) access(start time.Time, d time.Duration, method, uri, remote string) {
+	rw.push(C.GOSERVER_LOG_KIND_ACCESS, start, d, method, remote, uri)
+}
+
+// close marks the ring as finished and wakes the consumer one last time
+func (rw *ringLogWriter) close() {
+	rw.mu.Lock()
+	C.goserver_log_ring_close(rw.ring)
+	rw.mu.Unlock()
+	_, _ = rw.doorbell.Write([]byte{1})
+}
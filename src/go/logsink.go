@@ -0,0 +1,300 @@
+//go:build ignore
+// +build ignore
+
+// Native file log sink.
+//
+// With runServer(log_file = ...) the server writes its log straight to disk
+// from Go instead of sending it through the log pipe to an R callback. Writes
+// go through a large buffer that is flushed periodically, and the file is
+// rotated by size and/or age, keeping a fixed number of old segments which can
+// optionally be gzip-compressed. The R main thread is never involved, so the
+// log keeps up with the server even while R is busy.
+
+package main
+
+import (
+	"bufio"
+	"compress/gzip"
+	"fmt"
+	"io"
+	"os"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+// rotatingFileWriter is an io.Writer that appends to a log file with rotation
+type rotatingFileWriter struct {
+	dropped atomic.Uint64 // writes lost while the log file could not be opened
+
+	mu       sync.Mutex
+	path     string
+	file     *os.File
+	buf      *bufio.Writer
+	bufSize  int
+	size     int64 // bytes in the current segment
+	opened   time.Time
+	retryAt  time.Time     // earliest reopen after a failed open
+	closed   bool          // set by close, no more reopening
+	maxBytes int64         // rotate once the segment would exceed this (0 = never)
+	maxAge   time.Duration // rotate segments older than this (0 = never)
+	keep     int           // rotated segments to keep
+	compress bool          // gzip rotated segments
+
+	// Rotated segments waiting for the compressor, oldest first. Guarded by
+	// mu; the compressor goroutine alone renumbers segments when compressing.
+	queue      []string
+	wake       chan struct{}
+	compressed chan struct{} // closed when the compressor has exited
+
+	done    chan struct{}
+	flushed chan struct{}
+}
+
+func newRotatingFileWriter(path string, opts serverOptions) (*rotatingFileWriter, error) {
+	w := &rotatingFileWriter{
+		path:     path,
+		bufSize:  int(opts.int64("log_buffer_bytes", 256*1024)),
+		maxBytes: opts.int64("log_rotate_bytes", 0),
+		maxAge:   opts.duration("log_rotate_interval", 0),
+		keep:     int(opts.int64("log_keep", 5)),
+		compress: opts.bool("log_compress", false),
+		done:     make(chan struct{}),
+		flushed:  make(chan struct{}),
+	}
+	if w.bufSize <= 0 {
+		w.bufSize = 4096
+	}
+	if err := w.open(); err != nil {
+		return nil, err
+	}
+
+	flushEvery := opts.duration("log_flush_interval", time.Second)
+	if flushEvery <= 0 {
+		flushEvery = time.Second
+	}
+	go w.flushLoop(flushEvery)
+	if w.compress && w.keep > 0 {
+		w.wake = make(chan struct{}, 1)
+		w.compressed = make(chan struct{})
+		go w.compressLoop()
+	}
+	return w, nil
+}
+
+func (w *rotatingFileWriter) open() error {
+	f, err := os.OpenFile(w.path, os.O_CREATE|os.O_WRONLY|os.O_APPEND, 0o644)
+	if err != nil {
+		return err
+	}
+	info, err := f.Stat()
+	if err != nil {
+		f.Close()
+		return err
+	}
+	w.file = f
+	w.size = info.Size()
+	w.opened = time.Now()
+	if w.buf == nil {
+		w.buf = bufio.NewWriterSize(f, w.bufSize)
+	} else {
+		w.buf.Reset(f)
+	}
+	return nil
+}
+
+// reopen retries opening the log file after a rotation failed to, at most
+// once a second so a lasting failure does not cost a syscall per line.
+// Called with w.mu held.
+func (w *rotatingFileWriter) reopen() bool {
+	if w.closed || time.Now().Before(w.retryAt) {
+		return false
+	}
+	if err := w.open(); err != nil {
+		w.retryAt = time.Now().Add(time.Second)
+		return false
+	}
+	return true
+}
+
+func (w *rotatingFileWriter) Write(p []byte) (int, error) {
+	w.mu.Lock()
+	defer w.mu.Unlock()
+	if w.file == nil && !w.reopen() {
+		w.dropped.Add(1)
+		return 0, os.ErrClosed
+	}
+	if (w.maxBytes > 0 && w.size > 0 && w.size+int64(len(p)) > w.maxBytes) ||
+		(w.maxAge > 0 && time.Since(w.opened) >= w.maxAge) {
+		if err := w.rotate(); err != nil {
+			w.dropped.Add(1)
+			return 0, err
+		}
+	}
+	n, err := w.buf.Write(p)
+	w.size += int64(n)
+	return n, err
+}
+
+// segmentName returns the name of rotated segment i (1 = newest)
+func (w *rotatingFileWriter) segmentName(i int) string {
+	return fmt.Sprintf("%s.%d", w.path, i)
+}
+
+// rotate closes the current file, moves it aside and reopens. With
+// compression the segment is only renamed to a private name and queued;
+// the compressor numbers it once gzipped, so writers never wait for gzip.
+// If the new file cannot be opened, Write retries later. Called with w.mu
+// held.
+func (w *rotatingFileWriter) rotate() error {
+	if err := w.buf.Flush(); err != nil {
+		return err
+	}
+	w.file.Close()
+	w.file = nil
+
+	switch {
+	case w.keep <= 0:
+		os.Remove(w.path)
+	case w.compress:
+		pending := fmt.Sprintf("%s.%d.rotating", w.path, time.Now().UnixNano())
+		if os.Rename(w.path, pending) == nil {
+			w.queue = append(w.queue, pending)
+			select {
+			case w.wake <- struct{}{}:
+			default:
+			}
+		}
+	default:
+		w.shiftSegments()
+		os.Rename(w.path, w.segmentName(1))
+	}
+	if err := w.open(); err != nil {
+		w.retryAt = time.Now().Add(time.Second)
+		return err
+	}
+	return nil
+}
+
+// shiftSegments drops the oldest rotated segment and renumbers the others
+// to free segment 1
+func (w *rotatingFileWriter) shiftSegments() {
+	for _, suffix := range []string{"", ".gz"} {
+		os.Remove(w.segmentName(w.keep) + suffix)
+	}
+	for i := w.keep - 1; i >= 1; i-- {
+		for _, suffix := range []string{"", ".gz"} {
+			os.Rename(w.segmentName(i)+suffix, w.segmentName(i+1)+suffix)
+		}
+	}
+}
+
+// nextSegment pops the oldest segment waiting for compression
+func (w *rotatingFileWriter) nextSegment() (string, bool) {
+	w.mu.Lock()
+	defer w.mu.Unlock()
+	if len(w.queue) == 0 {
+		return "", false
+	}
+	name := w.queue[0]
+	w.queue = w.queue[1:]
+	return name, true
+}
+
+// compressLoop gzips rotated segments one at a time, in rotation order,
+// until close and the queue is empty
+func (w *rotatingFileWriter) compressLoop() {
+	defer close(w.compressed)
+	for {
+		name, ok := w.nextSegment()
+		if !ok {
+			select {
+			case <-w.wake:
+				continue
+			case <-w.done:
+				if name, ok = w.nextSegment(); !ok {
+					return
+				}
+			}
+		}
+		w.compressSegment(name)
+	}
+}
+
+// compressSegment gzips a queued segment and makes it segment 1. If gzip
+// fails the segment is kept uncompressed.
+func (w *rotatingFileWriter) compressSegment(pending string) {
+	from, suffix := pending+".gz", ".gz"
+	if err := gzipFile(pending, from); err != nil {
+		os.Remove(from)
+		from, suffix = pending, ""
+	}
+	w.shiftSegments()
+	if os.Rename(from, w.segmentName(1)+suffix) == nil && suffix != "" {
+		os.Remove(pending)
+	}
+}
+
+// gzipFile writes a gzip-compressed copy of src to dst
+func gzipFile(src, dst string) error {
+	in, err := os.Open(src)
+	if err != nil {
+		return err
+	}
+	defer in.Close()
+	out, err := os.Create(dst)
+	if err != nil {
+		return err
+	}
+	zw := gzip.NewWriter(out)
+	_, err = io.Copy(zw, in)
+	if cerr := zw.Close(); err == nil {
+		err = cerr
+	}
+	if cerr := out.Close(); err == nil {
+		err = cerr
+	}
+	return err
+}
+
+func (w *rotatingFileWriter) flushLoop(every time.Duration) {
+	defer close(w.flushed)
+	ticker := time.NewTicker(every)
+	defer ticker.Stop()
+	for {
+		select {
+		case <-w.done:
+			return
+		case <-ticker.C:
+			w.mu.Lock()
+			if w.file != nil {
+				_ = w.buf.Flush()
+			}
+			w.mu.Unlock()
+		}
+	}
+}
+
+// counters returns the log file counters as name/value pairs
+func (w *rotatingFileWriter) counters() []counter {
+	return []counter{
+		{"log_file_dropped", w.dropped.Load()},
+	}
+}
+
+// close flushes and closes the log file and waits for pending compression
+func (w *rotatingFileWriter) close() {
+	close(w.done)
+	<-w.flushed
+	w.mu.Lock()
+	w.closed = true
+	if w.file != nil {
+		_ = w.buf.Flush()
+		w.file.Close()
+		w.file = nil
+	}
+	w.mu.Unlock()
+	if w.compressed != nil {
+		<-w.compressed
+	}
+}
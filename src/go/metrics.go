@@ -0,0 +1,221 @@
+//go:build ignore
+// +build ignore
+
+// Per-mount request metrics.
+//
+// Every directory/prefix mount keeps its own counters and a log-linear
+// (HDR-style) latency histogram. All updates are single atomic adds, so the
+// request path takes no locks; readers (getServerStats() and the optional
+// Prometheus endpoint) load the counters individually, which is good enough
+// for monitoring even though a snapshot is not taken atomically as a whole.
+
+package main
+
+import (
+	"fmt"
+	"math/bits"
+	"net/http"
+	"strings"
+	"sync/atomic"
+	"time"
+)
+
+const (
+	histSubBits = 2 // 4 sub-buckets per power of two, i.e. <= 25% relative error
+	histSub     = 1 << histSubBits
+	histBuckets = 40 * histSub // covers up to 2^41 microseconds
+)
+
+// mountMetrics holds the counters of one mount
+type mountMetrics struct {
+	requests    atomic.Uint64
+	bytes       atomic.Uint64
+	latencyNs   atomic.Uint64
+	inFlight    atomic.Int64
+	cacheHits   atomic.Uint64
+	cacheMisses atomic.Uint64
+	status      [6]atomic.Uint64 // 1xx..5xx, other
+	hist        [histBuckets]atomic.Uint64
+
+	prefix string
+	dir    string
+}
+
+func newMountMetrics(prefix, dir string) *mountMetrics {
+	return &mountMetrics{prefix: prefix, dir: dir}
+}
+
+// histBucket maps a duration to its histogram bucket
+func histBucket(d time.Duration) int {
+	us := uint64(d / time.Microsecond)
+	if us < histSub {
+		return int(us)
+	}
+	exp := bits.Len64(us) - 1
+	sub := int(us>>(exp-histSubBits)) & (histSub - 1)
+	idx := (exp-histSubBits+1)*histSub + sub
+	if idx >= histBuckets {
+		idx = histBuckets - 1
+	}
+	return idx
+}
+
+// histUpper returns the exclusive upper bound of a bucket in microseconds
+func histUpper(idx int) uint64 {
+	if idx < histSub {
+		return uint64(idx + 1)
+	}
+	exp := idx/histSub + histSubBits - 1
+	sub := idx % histSub
+	return uint64(histSub+sub+1) << (exp - histSubBits)
+}
+
+// middleware counts requests served through next
+func (m *mountMetrics) middleware(next http.Handler) http.Handler {
+	return http.HandlerFunc(func(w http.ResponseWriter, r *http.Request) {
+		start := time.Now()
+		m.inFlight.Add(1)
+		rec := &responseRecorder{ResponseWriter: w}
+		next.ServeHTTP(rec, r)
+		m.inFlight.Add(-1)
+		m.observe(rec.statusCode(), rec.bytes, time.Since(start))
+	})
+}
+
+func (m *mountMetrics) observe(status int, bytes int64, d time.Duration) {
+	class := status/100 - 1
+	if class < 0 || class > 4 {
+		class = 5
+	}
+	m.requests.Add(1)
+	m.bytes.Add(uint64(bytes))
+	m.latencyNs.Add(uint64(d))
+	m.status[class].Add(1)
+	m.hist[histBucket(d)].Add(1)
+}
+
+// histogram loads the bucket counts and their total
+func (m *mountMetrics) histogram() ([histBuckets]uint64, uint64) {
+	var h [histBuckets]uint64
+	var total uint64
+	for i := range h {
+		h[i] = m.hist[i].Load()
+		total += h[i]
+	}
+	return h, total
+}
+
+// quantile returns the upper bound of the bucket holding quantile q, in ms
+func quantile(h [histBuckets]uint64, total uint64, q float64) float64 {
+	if total == 0 {
+		return 0
+	}
+	rank := uint64(q*float64(total) + 0.5)
+	if rank == 0 {
+		rank = 1
+	}
+	var seen uint64
+	for i, n := range h {
+		seen += n
+		if seen >= rank {
+			return float64(histUpper(i)) / 1000
+		}
+	}
+	return float64(histUpper(histBuckets-1)) / 1000
+}
+
+// formatMountStats renders the metrics of all mounts as a tab-separated
+// table with a header line, for getServerStats()
+func formatMountStats(mounts []*mountMetrics) string {
+	var b strings.Builder
+	b.WriteString("prefix\tdirectory\trequests\tbytes_sent\tin_flight\tstatus_1xx\tstatus_2xx\tstatus_3xx\tstatus_4xx\tstatus_5xx\tmean_ms\tp50_ms\tp90_ms\tp99_ms\tcache_hits\tcache_misses\tcache_hit_ratio\n")
+	for _, m := range mounts {
+		requests := m.requests.Load()
+		mean := 0.0
+		if requests > 0 {
+			mean = float64(m.latencyNs.Load()) / float64(requests) / 1e6
+		}
+		h, total := m.histogram()
+		fmt.Fprintf(&b, "%s\t%s\t%d\t%d\t%d", m.prefix, m.dir, requests,
+			m.bytes.Load(), m.inFlight.Load())
+		for class := 0; class < 5; class++ {
+			fmt.Fprintf(&b, "\t%d", m.status[class].Load())
+		}
+		fmt.Fprintf(&b, "\t%.3f\t%.3f\t%.3f\t%.3f", mean,
+			quantile(h, total, 0.50), quantile(h, total, 0.90), quantile(h, total, 0.99))
+		hits, misses := m.cacheHits.Load(), m.cacheMisses.Load()
+		ratio := 0.0
+		if hits+misses > 0 {
+			ratio = float64(hits) / float64(hits+misses)
+		}
+		fmt.Fprintf(&b, "\t%d\t%d\t%.4f\n", hits, misses, ratio)
+	}
+	return b.String()
+}
+
+// writePrometheus renders the metrics of all mounts in the Prometheus text
+// exposition format
+func writePrometheus(w *strings.Builder, mounts []*mountMetrics) {
+	header := func(name, kind, help string) {
+		fmt.Fprintf(w, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, kind)
+	}
+
+	header("goserver_requests_total", "counter", "Requests served per mount.")
+	for _, m := range mounts {
+		fmt.Fprintf(w, "goserver_requests_total{prefix=%q} %d\n", m.prefix, m.requests.Load())
+	}
+	header("goserver_response_bytes_total", "counter", "Response body bytes sent per mount.")
+	for _, m := range mounts {
+		fmt.Fprintf(w, "goserver_response_bytes_total{prefix=%q} %d\n", m.prefix, m.bytes.Load())
+	}
+	header("goserver_responses_total", "counter", "Responses per mount and status class.")
+	for _, m := range mounts {
+		for class := 0; class < 5; class++ {
+			fmt.Fprintf(w, "goserver_responses_total{prefix=%q,code=\"%dxx\"} %d\n",
+				m.prefix, class+1, m.status[class].Load())
+		}
+	}
+	header("goserver_cache_hits_total", "counter", "Requests served from the content cache per mount.")
+	for _, m := range mounts {
+		fmt.Fprintf(w, "goserver_cache_hits_total{prefix=%q} %d\n", m.prefix, m.cacheHits.Load())
+	}
+	header("goserver_cache_misses_total", "counter", "Cacheable files read from disk per mount.")
+	for _, m := range mounts {
+		fmt.Fprintf(w, "goserver_cache_misses_total{prefix=%q} %d\n", m.prefix, m.cacheMisses.Load())
+	}
+	header("goserver_in_flight_requests", "gauge", "Requests currently being served per mount.")
+	for _, m := range mounts {
+		fmt.Fprintf(w, "goserver_in_flight_requests{prefix=%q} %d\n", m.prefix, m.inFlight.Load())
+	}
+
+	// Powers of two from 16us to ~67s line up with histogram bucket edges
+	header("goserver_request_duration_seconds", "histogram", "Request latency per mount.")
+	for _, m := range mounts {
+		h, total := m.histogram()
+		var cumulative uint64
+		idx := 0
+		for exp := 4; exp <= 26; exp++ {
+			bound := uint64(1) << exp
+			for idx < histBuckets && histUpper(idx) <= bound {
+				cumulative += h[idx]
+				idx++
+			}
+			fmt.Fprintf(w, "goserver_request_duration_seconds_bucket{prefix=%q,le=\"%g\"} %d\n",
+				m.prefix, float64(bound)/1e6, cumulative)
+		}
+		fmt.Fprintf(w, "goserver_request_duration_seconds_bucket{prefix=%q,le=\"+Inf\"} %d\n", m.prefix, total)
+		fmt.Fprintf(w, "goserver_request_duration_seconds_sum{prefix=%q} %g\n",
+			m.prefix, float64(m.latencyNs.Load())/1e9)
+		fmt.Fprintf(w, "goserver_request_duration_seconds_count{prefix=%q} %d\n", m.prefix, total)
+	}
+}
+
+// metricsHandler serves the Prometheus endpoint of a server
+func metricsHandler(st *serverState) http.Handler {
+	return http.HandlerFunc(func(w http.ResponseWriter, r *http.Request) {
+		var b strings.Builder
+		writePrometheus(&b, st.routes.metrics())
+		w.Header().Set("Content-Type", "text/plain; version=0.0.4; charset=utf-8")
+		_, _ = w.Write([]byte(b.String()))
+	})
+}
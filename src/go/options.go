@@ -0,0 +1,72 @@
+//go:build ignore
+// +build ignore
+
+// Per-server options passed down from R.
+//
+// runServer() collects the tuning knobs that do not have a dedicated argument
+// in RunServerWithLogging into a character vector of "key=value" entries. The
+// C side joins them with newlines and Go parses them here. Unknown keys are
+// ignored so that R and Go can evolve independently.
+
+package main
+
+import (
+	"strconv"
+	"strings"
+	"time"
+)
+
+// serverOptions maps option names to their raw string values
+type serverOptions map[string]string
+
+// parseServerOptions parses newline-separated key=value pairs
+func parseServerOptions(s string) serverOptions {
+	opts := make(serverOptions)
+	for _, line := range strings.Split(s, "\n") {
+		kv := strings.SplitN(line, "=", 2)
+		if len(kv) != 2 || kv[0] == "" {
+			continue
+		}
+		opts[strings.TrimSpace(kv[0])] = kv[1]
+	}
+	return opts
+}
+
+func (o serverOptions) str(key, def string) string {
+	if v, ok := o[key]; ok && v != "" {
+		return v
+	}
+	return def
+}
+
+func (o serverOptions) int64(key string, def int64) int64 {
+	if v, err := strconv.ParseInt(strings.TrimSpace(o[key]), 10, 64); err == nil {
+		return v
+	}
+	return def
+}
+
+func (o serverOptions) bool(key string, def bool) bool {
+	switch strings.ToUpper(strings.TrimSpace(o[key])) {
+	case "TRUE", "1":
+		return true
+	case "FALSE", "0":
+		return false
+	}
+	return def
+}
+
+// duration reads a value given in (possibly fractional) seconds
+func (o serverOptions) duration(key string, def time.Duration) time.Duration {
+	if v, err := strconv.ParseFloat(strings.TrimSpace(o[key]), 64); err == nil {
+		return time.Duration(v * float64(time.Second))
+	}
+	return def
+}
+
+func (o serverOptions) float(key string, def float64) float64 {
+	if v, err := strconv.ParseFloat(strings.TrimSpace(o[key]), 64); err == nil {
+		return v
+	}
+	return def
+}
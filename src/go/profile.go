@@ -0,0 +1,196 @@
+//go:build ignore
+// +build ignore
+
+// Runtime profiling.
+//
+// startProfile() and stopProfile() write standard pprof files of the Go
+// runtime embedded in the R process. A CPU profile samples from start to
+// stop; mutex and block profiles switch sampling on at start and are written
+// at stop; heap and goroutine profiles are snapshots taken at stop. The Go
+// runtime is shared by all servers of the R session, so profiles cover all
+// of them. Servers started with pprof_addr also serve net/http/pprof on a
+// separate loopback listener.
+
+package main
+
+/*
+#include <stdlib.h>
+*/
+import "C"
+import (
+	"errors"
+	"fmt"
+	"net"
+	"net/http"
+	"net/http/pprof"
+	"os"
+	"runtime"
+	rpprof "runtime/pprof"
+	"sort"
+	"strings"
+	"sync"
+)
+
+// activeProfile is a profile between startProfile() and stopProfile()
+type activeProfile struct {
+	file     *os.File
+	prevRate int // mutex fraction or block rate to restore
+}
+
+var profiles = struct {
+	sync.Mutex
+	active    map[string]*activeProfile
+	blockRate int // set by block_profile_rate, restored after a block profile
+}{active: make(map[string]*activeProfile)}
+
+func startProfile(kind, path string, rate int) error {
+	switch kind {
+	case "cpu", "heap", "goroutine", "mutex", "block":
+	default:
+		return fmt.Errorf("unknown profile type %q", kind)
+	}
+	profiles.Lock()
+	defer profiles.Unlock()
+	if profiles.active[kind] != nil {
+		return fmt.Errorf("a %s profile is already running", kind)
+	}
+	f, err := os.Create(path)
+	if err != nil {
+		return err
+	}
+	p := &activeProfile{file: f}
+	switch kind {
+	case "cpu":
+		if err := rpprof.StartCPUProfile(f); err != nil {
+			f.Close()
+			os.Remove(path)
+			return err
+		}
+	case "mutex":
+		if rate <= 0 {
+			rate = 5
+		}
+		p.prevRate = runtime.SetMutexProfileFraction(rate)
+	case "block":
+		if rate <= 0 {
+			rate = 10000 // one sample per 10us spent blocked
+		}
+		runtime.SetBlockProfileRate(rate)
+	}
+	profiles.active[kind] = p
+	return nil
+}
+
+// stopProfile finishes a profile and returns the file it was written to
+func stopProfile(kind string) (string, error) {
+	profiles.Lock()
+	defer profiles.Unlock()
+	p := profiles.active[kind]
+	if p == nil {
+		return "", fmt.Errorf("no %s profile is running", kind)
+	}
+	delete(profiles.active, kind)
+	var err error
+	switch kind {
+	case "cpu":
+		rpprof.StopCPUProfile()
+	case "heap":
+		runtime.GC() // up-to-date live heap, as net/http/pprof's ?gc=1
+		err = rpprof.Lookup("heap").WriteTo(p.file, 0)
+	default:
+		err = rpprof.Lookup(kind).WriteTo(p.file, 0)
+	}
+	switch kind {
+	case "mutex":
+		runtime.SetMutexProfileFraction(p.prevRate)
+	case "block":
+		// SetBlockProfileRate does not report the previous rate
+		runtime.SetBlockProfileRate(profiles.blockRate)
+	}
+	if cerr := p.file.Close(); err == nil {
+		err = cerr
+	}
+	return p.file.Name(), err
+}
+
+// StartProfile starts a profile of the given type written to path. rate is
+// the mutex profile fraction or block profile rate (0 = default). Returns ""
+// or an error message; the caller frees the result.
+//
+//export StartProfile
+func StartProfile(cType, cPath *C.char, rate C.int) *C.char {
+	if err := startProfile(C.GoString(cType), C.GoString(cPath), int(rate)); err != nil {
+		return C.CString(err.Error())
+	}
+	return C.CString("")
+}
+
+// StopProfiles stops the profile of the given type, or all running ones
+// for "", and returns "ok" followed by the written files, one per line, or
+// an error message. The caller frees the result.
+//
+//export StopProfiles
+func StopProfiles(cType *C.char) *C.char {
+	kinds := []string{C.GoString(cType)}
+	if kinds[0] == "" {
+		profiles.Lock()
+		kinds = kinds[:0]
+		for kind := range profiles.active {
+			kinds = append(kinds, kind)
+		}
+		profiles.Unlock()
+		sort.Strings(kinds)
+	}
+	var b strings.Builder
+	var errs []string
+	for _, kind := range kinds {
+		path, err := stopProfile(kind)
+		if err != nil {
+			errs = append(errs, err.Error())
+			continue
+		}
+		b.WriteString("\n" + path)
+	}
+	if len(errs) > 0 {
+		return C.CString(strings.Join(errs, "; "))
+	}
+	return C.CString("ok" + b.String())
+}
+
+// applyProfileRates sets the process-wide mutex and block sampling from
+// server options, so pprof_addr has data to serve
+func applyProfileRates(opts serverOptions) {
+	if rate := opts.int64("mutex_profile_fraction", 0); rate > 0 {
+		runtime.SetMutexProfileFraction(int(rate))
+	}
+	if rate := opts.int64("block_profile_rate", 0); rate > 0 {
+		profiles.Lock()
+		profiles.blockRate = int(rate)
+		if profiles.active["block"] == nil {
+			runtime.SetBlockProfileRate(int(rate))
+		}
+		profiles.Unlock()
+	}
+}
+
+// newPprofServer serves net/http/pprof on a loopback address
+func newPprofServer(addr string) (*http.Server, net.Listener, error) {
+	host, _, err := net.SplitHostPort(addr)
+	if err != nil {
+		return nil, nil, err
+	}
+	if ip := net.ParseIP(host); host != "localhost" && (ip == nil || !ip.IsLoopback()) {
+		return nil, nil, errors.New("pprof_addr must be a loopback address")
+	}
+	ln, err := net.Listen("tcp", addr)
+	if err != nil {
+		return nil, nil, err
+	}
+	mux := http.NewServeMux()
+	mux.HandleFunc("/debug/pprof/", pprof.Index)
+	mux.HandleFunc("/debug/pprof/cmdline", pprof.Cmdline)
+	mux.HandleFunc("/debug/pprof/profile", pprof.Profile)
+	mux.HandleFunc("/debug/pprof/symbol", pprof.Symbol)
+	mux.HandleFunc("/debug/pprof/trace", pprof.Trace)
+	return &http.Server{Handler: mux}, ln, nil
+}
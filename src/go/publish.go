@@ -0,0 +1,242 @@
+//go:build ignore
+// +build ignore
+
+// Published R objects.
+//
+// publishRaw() serves an R raw vector at a fixed URL path straight from R's
+// memory: the C side pins the vector with R_PreserveObject and hands its
+// address here, and responses are written from that memory in place, with
+// Range, HEAD and ETag revalidation from http.ServeContent. Published paths
+// take precedence over the mounts and go through the same auth, rate limit
+// and CORS middleware.
+//
+// The memory belongs to R, so reads and unpinning are ordered by a lock on
+// each object: once an object is closed no reader touches it again and C
+// may release the vector. Unpublishing or replacing an object closes it,
+// cutting off downloads still in flight, and the server closes all of its
+// objects before RunServerWithLogging returns.
+
+package main
+
+/*
+#include <stdlib.h>
+*/
+import "C"
+import (
+	"crypto/rand"
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"io"
+	"net/http"
+	"path"
+	"strings"
+	"sync"
+	"sync/atomic"
+	"time"
+	"unsafe"
+)
+
+// rawObject is one published vector
+type rawObject struct {
+	mu          sync.RWMutex
+	data        []byte // R memory, valid until closed
+	closed      bool
+	contentType string
+	etag        string
+	modTime     time.Time
+}
+
+func (o *rawObject) close() {
+	o.mu.Lock()
+	o.closed = true
+	o.data = nil
+	o.mu.Unlock()
+}
+
+// rawReader reads an object for one response
+type rawReader struct {
+	obj  *rawObject
+	size int64
+	off  int64
+}
+
+var errUnpublished = errors.New("object was unpublished")
+
+func (r *rawReader) Read(p []byte) (int, error) {
+	if r.off >= r.size {
+		return 0, io.EOF
+	}
+	r.obj.mu.RLock()
+	defer r.obj.mu.RUnlock()
+	if r.obj.closed {
+		return 0, errUnpublished
+	}
+	n := copy(p, r.obj.data[r.off:])
+	r.off += int64(n)
+	return n, nil
+}
+
+func (r *rawReader) Seek(offset int64, whence int) (int64, error) {
+	switch whence {
+	case io.SeekStart:
+	case io.SeekCurrent:
+		offset += r.off
+	case io.SeekEnd:
+		offset += r.size
+	default:
+		return 0, errors.New("invalid whence")
+	}
+	if offset < 0 {
+		return 0, errors.New("negative position")
+	}
+	r.off = offset
+	return offset, nil
+}
+
+// rawStore holds the published objects of a server in a copy-on-write map
+// so that lookups on the request path take no lock
+type rawStore struct {
+	requests atomic.Uint64
+	seq      atomic.Uint64
+
+	objects atomic.Value // map[string]*rawObject
+	nonce   uint64       // random per store, so ETags never repeat across servers
+	mu      sync.Mutex   // serializes updates
+	closed  bool
+	next    http.Handler // the mounts
+	handler http.Handler // serves objects behind the server's middleware
+}
+
+// newRawStore serves published objects in front of next; wrap adds the
+// middleware of the server's mounts
+func newRawStore(next http.Handler, wrap func(http.Handler) http.Handler) *rawStore {
+	s := &rawStore{next: next}
+	var nonce [8]byte
+	if _, err := rand.Read(nonce[:]); err != nil {
+		binary.BigEndian.PutUint64(nonce[:], uint64(time.Now().UnixNano()))
+	}
+	s.nonce = binary.BigEndian.Uint64(nonce[:])
+	s.objects.Store(map[string]*rawObject{})
+	s.handler = wrap(http.HandlerFunc(s.serve))
+	return s
+}
+
+func (s *rawStore) lookup(p string) *rawObject {
+	return s.objects.Load().(map[string]*rawObject)[p]
+}
+
+func (s *rawStore) ServeHTTP(w http.ResponseWriter, r *http.Request) {
+	if s.lookup(r.URL.Path) != nil {
+		s.handler.ServeHTTP(w, r)
+		return
+	}
+	s.next.ServeHTTP(w, r)
+}
+
+func (s *rawStore) serve(w http.ResponseWriter, r *http.Request) {
+	obj := s.lookup(r.URL.Path)
+	if obj == nil {
+		// Unpublished after ServeHTTP looked
+		http.NotFound(w, r)
+		return
+	}
+	s.requests.Add(1)
+	obj.mu.RLock()
+	size := int64(len(obj.data))
+	obj.mu.RUnlock()
+	w.Header().Set("ETag", obj.etag)
+	if obj.contentType != "" {
+		w.Header().Set("Content-Type", obj.contentType)
+	}
+	http.ServeContent(w, r, path.Base(r.URL.Path), obj.modTime, &rawReader{obj: obj, size: size})
+}
+
+// update publishes a copy of the map with p set to obj, or removed for nil,
+// and closes the object it replaces
+func (s *rawStore) update(p string, obj *rawObject) error {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	if s.closed {
+		return errors.New("server is shutting down")
+	}
+	old := s.objects.Load().(map[string]*rawObject)
+	prev := old[p]
+	if obj == nil && prev == nil {
+		return fmt.Errorf("path %q is not published", p)
+	}
+	objects := make(map[string]*rawObject, len(old)+1)
+	for k, v := range old {
+		objects[k] = v
+	}
+	if obj != nil {
+		objects[p] = obj
+	} else {
+		delete(objects, p)
+	}
+	s.objects.Store(objects)
+	if prev != nil {
+		prev.close()
+	}
+	return nil
+}
+
+func (s *rawStore) publish(p string, data []byte, contentType string) error {
+	if !strings.HasPrefix(p, "/") || strings.ContainsAny(p, "\n\x00") {
+		return fmt.Errorf("invalid path %q", p)
+	}
+	obj := &rawObject{
+		data:        data,
+		contentType: contentType,
+		etag:        fmt.Sprintf("\"r%x-%x-%x\"", s.nonce, s.seq.Add(1), len(data)),
+		modTime:     time.Now(),
+	}
+	return s.update(p, obj)
+}
+
+// close closes all objects; afterwards none of their memory is read
+func (s *rawStore) close() {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	s.closed = true
+	for _, obj := range s.objects.Load().(map[string]*rawObject) {
+		obj.close()
+	}
+	s.objects.Store(map[string]*rawObject{})
+}
+
+func (s *rawStore) counters() []counter {
+	objects := s.objects.Load().(map[string]*rawObject)
+	var bytes uint64
+	for _, obj := range objects {
+		obj.mu.RLock()
+		bytes += uint64(len(obj.data))
+		obj.mu.RUnlock()
+	}
+	return []counter{
+		{"published_objects", uint64(len(objects))},
+		{"published_bytes", bytes},
+		{"published_requests", s.requests.Load()},
+	}
+}
+
+// PublishRaw serves size bytes at data, which the caller keeps valid until
+// the path is unpublished or replaced, or the server has stopped. Returns ""
+// on success, an error message otherwise, or NULL if no server with that id
+// is running. The caller frees the result.
+//
+//export PublishRaw
+func PublishRaw(id C.int, cPath *C.char, data unsafe.Pointer, size C.longlong, cContentType *C.char) *C.char {
+	st := lookupServer(int(id))
+	if st == nil {
+		return nil
+	}
+	var buf []byte
+	if size > 0 {
+		buf = unsafe.Slice((*byte)(data), int(size))
+	}
+	if err := st.published.publish(C.GoString(cPath), buf, C.GoString(cContentType)); err != nil {
+		return C.CString(err.Error())
+	}
+	return C.CString("")
+}
@@ -0,0 +1,274 @@
+//go:build ignore
+// +build ignore
+
+// Rate limiting and bandwidth shaping.
+//
+// Each client, identified by remote IP or by API key, gets two token
+// buckets: one for requests, which answers 429 when empty, and one for
+// response bytes, which delays writes until the client is back within its
+// rate. Concurrent downloads of one client share its byte bucket, so a
+// client pulling whole BAMs cannot take more than its share of the uplink.
+// Buckets live in hash-sharded maps to keep lock contention low. Limits can
+// be changed at runtime through ServerCommand("rate_limit"); doing so resets
+// all buckets.
+
+package main
+
+import (
+	"context"
+	"hash/fnv"
+	"io"
+	"math"
+	"net/http"
+	"strconv"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+const (
+	rateShards          = 64
+	rateShardMaxBuckets = 4096 // per shard, before idle buckets are dropped
+	rateChunk           = 32 << 10
+)
+
+// rateConfig is an immutable set of limits; 0 rates disable a limit
+type rateConfig struct {
+	byAPIKey     bool
+	requestRate  float64 // requests per second
+	requestBurst float64
+	byteRate     float64 // bytes per second
+	byteBurst    float64
+}
+
+func parseRateConfig(opts serverOptions) *rateConfig {
+	c := &rateConfig{
+		byAPIKey:     opts.str("rate_limit_key", "ip") == "api_key",
+		requestRate:  opts.float("rate_limit_requests", 0),
+		requestBurst: opts.float("rate_limit_request_burst", 0),
+		byteRate:     opts.float("rate_limit_bytes", 0),
+		byteBurst:    opts.float("rate_limit_byte_burst", 0),
+	}
+	if c.requestBurst <= 0 {
+		c.requestBurst = math.Max(1, c.requestRate)
+	}
+	if c.byteBurst <= 0 {
+		c.byteBurst = c.byteRate // one second's worth
+	}
+	return c
+}
+
+// tokenBucket refills at rate tokens per second up to burst. Tokens may go
+// negative, which makes later takers wait for the debt to be repaid.
+type tokenBucket struct {
+	tokens float64
+	last   time.Time
+}
+
+func (b *tokenBucket) refill(now time.Time, rate, burst float64) {
+	b.tokens = math.Min(burst, b.tokens+now.Sub(b.last).Seconds()*rate)
+	b.last = now
+}
+
+type clientBuckets struct {
+	requests tokenBucket
+	bytes    tokenBucket
+}
+
+type rateShard struct {
+	mu      sync.Mutex
+	clients map[string]*clientBuckets
+}
+
+type rateLimiter struct {
+	rejected atomic.Uint64
+	delayNs  atomic.Uint64
+
+	config atomic.Value // *rateConfig
+	shards [rateShards]rateShard
+
+	// validKey reports whether an API key would pass auth (nil: no keys)
+	validKey func(string) bool
+}
+
+func newRateLimiter(opts serverOptions) *rateLimiter {
+	l := &rateLimiter{}
+	l.configure(parseRateConfig(opts))
+	return l
+}
+
+// configure installs new limits and forgets all client state
+func (l *rateLimiter) configure(c *rateConfig) {
+	for i := range l.shards {
+		s := &l.shards[i]
+		s.mu.Lock()
+		s.clients = make(map[string]*clientBuckets)
+		s.mu.Unlock()
+	}
+	l.config.Store(c)
+}
+
+// buckets returns the buckets of a client, creating full ones if needed.
+// Called with s.mu held.
+func (s *rateShard) buckets(client string, now time.Time, c *rateConfig) *clientBuckets {
+	b := s.clients[client]
+	if b != nil {
+		return b
+	}
+	if len(s.clients) >= rateShardMaxBuckets {
+		// Buckets that have refilled completely carry no state
+		for key, old := range s.clients {
+			old.requests.refill(now, c.requestRate, c.requestBurst)
+			old.bytes.refill(now, c.byteRate, c.byteBurst)
+			if old.requests.tokens >= c.requestBurst && old.bytes.tokens >= c.byteBurst {
+				delete(s.clients, key)
+			}
+		}
+	}
+	b = &clientBuckets{
+		requests: tokenBucket{tokens: c.requestBurst, last: now},
+		bytes:    tokenBucket{tokens: c.byteBurst, last: now},
+	}
+	s.clients[client] = b
+	return b
+}
+
+func (l *rateLimiter) shard(client string) *rateShard {
+	h := fnv.New32a()
+	h.Write([]byte(client))
+	return &l.shards[h.Sum32()%rateShards]
+}
+
+// allowRequest takes a request token and returns 0, or the time until one
+// is available
+func (l *rateLimiter) allowRequest(client string, c *rateConfig) time.Duration {
+	s := l.shard(client)
+	now := time.Now()
+	s.mu.Lock()
+	b := s.buckets(client, now, c)
+	b.requests.refill(now, c.requestRate, c.requestBurst)
+	if b.requests.tokens >= 1 {
+		b.requests.tokens--
+		s.mu.Unlock()
+		return 0
+	}
+	wait := time.Duration((1 - b.requests.tokens) / c.requestRate * float64(time.Second))
+	s.mu.Unlock()
+	return wait
+}
+
+// takeBytes charges n bytes to a client and returns how long to wait before
+// sending them
+func (l *rateLimiter) takeBytes(client string, n int, c *rateConfig) time.Duration {
+	s := l.shard(client)
+	now := time.Now()
+	s.mu.Lock()
+	b := s.buckets(client, now, c)
+	b.bytes.refill(now, c.byteRate, c.byteBurst)
+	b.bytes.tokens -= float64(n)
+	tokens := b.bytes.tokens
+	s.mu.Unlock()
+	if tokens >= 0 {
+		return 0
+	}
+	return time.Duration(-tokens / c.byteRate * float64(time.Second))
+}
+
+// rateClient returns the bucket key of a request. Limits run before auth,
+// so only a key that would pass it gets its own bucket; a made-up key on
+// every request would otherwise get a fresh, full one.
+func (l *rateLimiter) rateClient(r *http.Request, c *rateConfig) string {
+	if c.byAPIKey && l.validKey != nil {
+		key := r.Header.Get("X-API-Key")
+		if key == "" {
+			key = queryValue(r.URL.RawQuery, "api_key")
+		}
+		if key != "" && l.validKey(key) {
+			return "k:" + key
+		}
+	}
+	return "a:" + clientHost(r.RemoteAddr)
+}
+
+// middleware applies the current limits to requests served through next
+func (l *rateLimiter) middleware(next http.Handler) http.Handler {
+	return http.HandlerFunc(func(w http.ResponseWriter, r *http.Request) {
+		c := l.config.Load().(*rateConfig)
+		if c.requestRate <= 0 && c.byteRate <= 0 {
+			next.ServeHTTP(w, r)
+			return
+		}
+		client := l.rateClient(r, c)
+		if c.requestRate > 0 {
+			if wait := l.allowRequest(client, c); wait > 0 {
+				l.rejected.Add(1)
+				w.Header().Set("Retry-After", strconv.Itoa(int(math.Ceil(wait.Seconds()))))
+				http.Error(w, "Too Many Requests", http.StatusTooManyRequests)
+				return
+			}
+		}
+		if c.byteRate > 0 {
+			w = &shapedWriter{ResponseWriter: w, limiter: l, client: client, config: c, ctx: r.Context()}
+		}
+		next.ServeHTTP(w, r)
+	})
+}
+
+// shapedWriter paces response bytes through a client's byte bucket. It
+// gives up the sendfile path, which is only taken for unshaped clients.
+type shapedWriter struct {
+	http.ResponseWriter
+	limiter *rateLimiter
+	client  string
+	config  *rateConfig
+	ctx     context.Context
+}
+
+func (w *shapedWriter) Write(b []byte) (int, error) {
+	written := 0
+	for len(b) > 0 {
+		n := len(b)
+		if n > rateChunk {
+			n = rateChunk
+		}
+		if wait := w.limiter.takeBytes(w.client, n, w.config); wait > 0 {
+			w.limiter.delayNs.Add(uint64(wait))
+			t := time.NewTimer(wait)
+			select {
+			case <-t.C:
+			case <-w.ctx.Done():
+				t.Stop()
+				return written, w.ctx.Err()
+			}
+		}
+		m, err := w.ResponseWriter.Write(b[:n])
+		written += m
+		if err != nil {
+			return written, err
+		}
+		b = b[n:]
+	}
+	return written, nil
+}
+
+// ReadFrom hides the underlying ReaderFrom so every byte goes through Write
+func (w *shapedWriter) ReadFrom(r io.Reader) (int64, error) {
+	buf := make([]byte, rateChunk)
+	return io.CopyBuffer(writerOnly{w}, r, buf)
+}
+
+type writerOnly struct{ io.Writer }
+
+func (w *shapedWriter) Flush() {
+	if f, ok := w.ResponseWriter.(http.Flusher); ok {
+		f.Flush()
+	}
+}
+
+// counters returns the rate limiting counters as name/value pairs
+func (l *rateLimiter) counters() []counter {
+	return []counter{
+		{"ratelimit_rejected", l.rejected.Load()},
+		{"ratelimit_delay_ms", l.delayNs.Load() / uint64(time.Millisecond)},
+	}
+}
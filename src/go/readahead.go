@@ -0,0 +1,215 @@
+//go:build ignore
+// +build ignore
+
+// Sequential range detection and kernel readahead hints.
+//
+// Genome browsers stream a region of a BAM/CRAM file as a series of
+// consecutive Range requests, each of which would otherwise be read cold. The
+// tracker below remembers, per client and file, where the last range ended.
+// Once ranges keep continuing forward it asks the kernel to prefetch the next
+// window (POSIX_FADV_WILLNEED), growing the window while the pattern holds;
+// for clients that jump around it disables kernel readahead on the file
+// (POSIX_FADV_RANDOM) so no bandwidth is wasted. Hints are only available on
+// Linux; elsewhere the tracker is disabled.
+
+package main
+
+/*
+#ifdef __linux__
+#include <fcntl.h>
+#define GOSERVER_HAVE_FADVISE 1
+#define GOSERVER_FADV_WILLNEED POSIX_FADV_WILLNEED
+#define GOSERVER_FADV_RANDOM POSIX_FADV_RANDOM
+static int goserver_fadvise(int fd, long long offset, long long len, int advice) {
+    return posix_fadvise(fd, (off_t)offset, (off_t)len, advice);
+}
+#else
+#define GOSERVER_HAVE_FADVISE 0
+#define GOSERVER_FADV_WILLNEED 0
+#define GOSERVER_FADV_RANDOM 0
+static int goserver_fadvise(int fd, long long offset, long long len, int advice) {
+    return 0;
+}
+#endif
+*/
+import "C"
+import (
+	"net"
+	"os"
+	"strconv"
+	"strings"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+const (
+	readaheadMaxStreams = 4096             // tracked (client, file) pairs
+	readaheadIdle       = 30 * time.Second // forget streams idle this long
+	readaheadGrowth     = 16               // window grows up to this multiple
+	readaheadSeqHits    = 2                // consecutive ranges before prefetching
+)
+
+// rangeStream is the access pattern of one client on one file
+type rangeStream struct {
+	end        int64 // end (exclusive) of the last range
+	prefetched int64 // end of the last prefetched window
+	window     int64
+	sequential int
+	random     int
+	lastSeen   time.Time
+}
+
+type readaheadTracker struct {
+	sequential atomic.Uint64
+	random     atomic.Uint64
+	advised    atomic.Uint64
+
+	mu      sync.Mutex
+	streams map[string]*rangeStream
+}
+
+// newReadaheadTracker returns nil where hints are unavailable. The tracker
+// is created even if no mount has a window yet, since addMount() may add one.
+func newReadaheadTracker() *readaheadTracker {
+	if C.GOSERVER_HAVE_FADVISE == 0 {
+		return nil
+	}
+	return &readaheadTracker{streams: make(map[string]*rangeStream)}
+}
+
+// parseMountInt64s reads a comma-separated per-mount option, recycling a
+// single value over all mounts
+func parseMountInt64s(value string, n int) []int64 {
+	out := make([]int64, n)
+	if value == "" {
+		return out
+	}
+	parts := strings.Split(value, ",")
+	for i := range out {
+		v, err := strconv.ParseInt(strings.TrimSpace(parts[i%len(parts)]), 10, 64)
+		if err == nil {
+			out[i] = v
+		}
+	}
+	return out
+}
+
+// firstRange returns the first byte range of a Range header for a file of
+// the given size. Suffix and multi-part ranges are not tracked.
+func firstRange(header string, size int64) (start, end int64, ok bool) {
+	if !strings.HasPrefix(header, "bytes=") || strings.Contains(header, ",") {
+		return 0, 0, false
+	}
+	spec := strings.TrimSpace(header[len("bytes="):])
+	i := strings.IndexByte(spec, '-')
+	if i <= 0 {
+		return 0, 0, false
+	}
+	start, err := strconv.ParseInt(spec[:i], 10, 64)
+	if err != nil || start >= size {
+		return 0, 0, false
+	}
+	end = size
+	if rest := spec[i+1:]; rest != "" {
+		last, err := strconv.ParseInt(rest, 10, 64)
+		if err != nil || last < start {
+			return 0, 0, false
+		}
+		if last+1 < size {
+			end = last + 1
+		}
+	}
+	return start, end, true
+}
+
+// clientHost strips the port from a remote address, since every connection
+// of a client has a different one
+func clientHost(remoteAddr string) string {
+	if host, _, err := net.SplitHostPort(remoteAddr); err == nil {
+		return host
+	}
+	return remoteAddr
+}
+
+// advise records the range [start, end) read by client from f and issues
+// readahead hints for the pattern seen so far
+func (t *readaheadTracker) advise(f *os.File, client, name string, start, end, size, window int64) {
+	now := time.Now()
+	key := client + "\x00" + name
+
+	t.mu.Lock()
+	s := t.streams[key]
+	if s == nil {
+		if len(t.streams) >= readaheadMaxStreams {
+			t.expire(now)
+		}
+		s = &rangeStream{end: -1, window: window}
+		t.streams[key] = s
+	}
+	// Small forward gaps (skipped blocks) still count as sequential
+	isSequential := s.end >= 0 && start >= s.end && start-s.end <= window
+	var adviseFrom, adviseLen int64
+	random := false
+	if isSequential {
+		s.sequential++
+		s.random = 0
+		if s.sequential >= readaheadSeqHits {
+			from := end
+			if s.prefetched > from {
+				from = s.prefetched
+			}
+			if to := end + s.window; to > from && from < size {
+				if to > size {
+					to = size
+				}
+				adviseFrom, adviseLen = from, to-from
+				s.prefetched = to
+			}
+			if s.window < window*readaheadGrowth {
+				s.window *= 2
+			}
+		}
+	} else if s.end >= 0 {
+		s.random++
+		s.sequential = 0
+		s.window = window
+		s.prefetched = 0
+		random = s.random >= readaheadSeqHits
+	}
+	s.end = end
+	s.lastSeen = now
+	t.mu.Unlock()
+
+	fd := C.int(f.Fd())
+	if adviseLen > 0 {
+		t.sequential.Add(1)
+		t.advised.Add(uint64(adviseLen))
+		C.goserver_fadvise(fd, C.longlong(adviseFrom), C.longlong(adviseLen), C.GOSERVER_FADV_WILLNEED)
+	} else if random {
+		t.random.Add(1)
+		C.goserver_fadvise(fd, 0, 0, C.GOSERVER_FADV_RANDOM)
+	}
+}
+
+// expire drops idle streams, or all of them if none are idle.
+// Called with t.mu held.
+func (t *readaheadTracker) expire(now time.Time) {
+	for key, s := range t.streams {
+		if now.Sub(s.lastSeen) > readaheadIdle {
+			delete(t.streams, key)
+		}
+	}
+	if len(t.streams) >= readaheadMaxStreams {
+		t.streams = make(map[string]*rangeStream)
+	}
+}
+
+// counters returns the readahead counters as name/value pairs
+func (t *readaheadTracker) counters() []counter {
+	return []counter{
+		{"readahead_sequential", t.sequential.Load()},
+		{"readahead_random", t.random.Load()},
+		{"readahead_bytes", t.advised.Load()},
+	}
+}
@@ -0,0 +1,212 @@
+//go:build ignore
+// +build ignore
+
+// Registry of running servers.
+//
+// The C side gives every server a numeric id and passes it to
+// RunServerWithLogging. Running servers register their state here so that
+// exported query functions can find it from R without going through a pipe.
+
+package main
+
+/*
+#include <stdlib.h>
+*/
+import "C"
+import (
+	"errors"
+	"fmt"
+	"math"
+	"strconv"
+	"strings"
+	"sync"
+	"time"
+)
+
+// serverState is the live, queryable state of one running server
+type serverState struct {
+	id        int
+	access    *accessLog
+	logFile   *rotatingFileWriter // nil without log_file
+	cache     *contentCache       // nil when caching is disabled
+	readahead *readaheadTracker   // nil when readahead hints are disabled
+	compress  *compressor         // nil when compression is disabled
+	etags     bool                // strong ETags on regular files
+	listings  *listingCache
+	tls       *tlsState // nil without TLS
+	conns     *connLimits
+	limiter   *rateLimiter
+	routes    *router
+	published *rawStore
+	signer    *urlSigner // nil without sign_secret
+}
+
+// counter is one named value reported to R
+type counter struct {
+	name  string
+	value uint64
+}
+
+var registry = struct {
+	sync.Mutex
+	servers map[int]*serverState
+}{servers: make(map[int]*serverState)}
+
+func registerServer(st *serverState) {
+	registry.Lock()
+	registry.servers[st.id] = st
+	registry.Unlock()
+}
+
+func unregisterServer(id int) {
+	registry.Lock()
+	delete(registry.servers, id)
+	registry.Unlock()
+}
+
+func lookupServer(id int) *serverState {
+	registry.Lock()
+	defer registry.Unlock()
+	return registry.servers[id]
+}
+
+// formatCounters renders counters as "name=value" lines
+func formatCounters(counters []counter) string {
+	var b strings.Builder
+	for _, c := range counters {
+		b.WriteString(c.name)
+		b.WriteByte('=')
+		b.WriteString(strconv.FormatUint(c.value, 10))
+		b.WriteByte('\n')
+	}
+	return b.String()
+}
+
+// ServerCounters returns the counters of a running server as "name=value"
+// lines, or NULL if no server with that id is running. The caller frees the
+// result.
+//
+//export ServerCounters
+func ServerCounters(id C.int) *C.char {
+	st := lookupServer(int(id))
+	if st == nil {
+		return nil
+	}
+	counters := append(st.access.counters(), st.conns.counters()...)
+	if st.logFile != nil {
+		counters = append(counters, st.logFile.counters()...)
+	}
+	counters = append(counters, st.limiter.counters()...)
+	counters = append(counters, st.published.counters()...)
+	if st.cache != nil {
+		counters = append(counters, st.cache.counters("cache")...)
+	}
+	if st.readahead != nil {
+		counters = append(counters, st.readahead.counters()...)
+	}
+	if st.compress != nil {
+		counters = append(counters, st.compress.counters()...)
+	}
+	counters = append(counters, st.listings.counters()...)
+	if st.tls != nil {
+		counters = append(counters, st.tls.counters()...)
+	}
+	return C.CString(formatCounters(counters))
+}
+
+// ServerCommand performs an action on a running server. It returns "" on
+// success, an error message otherwise, or NULL if no server with that id is
+// running. The caller frees the result.
+//
+//export ServerCommand
+func ServerCommand(id C.int, cCommand *C.char) (result *C.char) {
+	st := lookupServer(int(id))
+	if st == nil {
+		return nil
+	}
+	// A panic must not unwind into R
+	defer func() {
+		if r := recover(); r != nil {
+			result = C.CString(fmt.Sprintf("command failed: %v", r))
+		}
+	}()
+
+	// The first line names the command; option lines may follow
+	var err error
+	command, args := C.GoString(cCommand), ""
+	if i := strings.IndexByte(command, '\n'); i >= 0 {
+		command, args = command[:i], command[i+1:]
+	}
+	switch command {
+	case "reload_tls":
+		if st.tls == nil {
+			err = errors.New("TLS is not enabled on this server")
+		} else {
+			err = st.tls.reload()
+		}
+	case "add_mount":
+		opts := parseServerOptions(args)
+		err = st.routes.add(safeClean(opts.str("dir", "")), opts.str("prefix", ""),
+			opts.int64("readahead_window", 0), opts.bool("dir_listing", true))
+	case "remove_mount":
+		err = st.routes.remove(parseServerOptions(args).str("prefix", ""))
+	case "unpublish":
+		err = st.published.update(parseServerOptions(args).str("path", ""), nil)
+	case "rate_limit":
+		st.limiter.configure(parseRateConfig(parseServerOptions(args)))
+	default:
+		err = fmt.Errorf("unknown command %q", command)
+	}
+	if err != nil {
+		return C.CString(err.Error())
+	}
+	return C.CString("")
+}
+
+// ServerQuery returns a text report about a running server, or NULL if no
+// server with that id is running. A report that could not be produced comes
+// back as "query failed: <reason>", which no report starts with. The caller
+// frees the result.
+//
+//export ServerQuery
+func ServerQuery(id C.int, cWhat *C.char) (result *C.char) {
+	st := lookupServer(int(id))
+	if st == nil {
+		return nil
+	}
+	// A panic must not unwind into R
+	defer func() {
+		if r := recover(); r != nil {
+			result = C.CString(fmt.Sprintf("query failed: %v", r))
+		}
+	}()
+
+	// The first line names the report; option lines may follow
+	what, args := C.GoString(cWhat), ""
+	if i := strings.IndexByte(what, '\n'); i >= 0 {
+		what, args = what[:i], what[i+1:]
+	}
+	switch what {
+	case "sign":
+		// "" when URL signing is not enabled
+		if st.signer == nil {
+			return C.CString("")
+		}
+		opts := parseServerOptions(args)
+		return C.CString(st.signer.sign(opts.str("path", "/"), opts.int64("expires", 0)))
+	case "access_log":
+		opts := parseServerOptions(args)
+		since := time.Unix(0, 0)
+		if t := opts.float("since", 0); t > 0 {
+			since = time.UnixMicro(int64(math.Round(t * 1e6)))
+		}
+		return C.CString(st.access.records.format(int(opts.int64("n", 0)), since))
+	case "stats":
+		return C.CString(formatMountStats(st.routes.metrics()))
+	case "metrics":
+		var b strings.Builder
+		writePrometheus(&b, st.routes.metrics())
+		return C.CString(b.String())
+	}
+	return nil
+}
@@ -0,0 +1,134 @@
+//go:build ignore
+// +build ignore
+
+// Mount routing.
+//
+// The directory/prefix mounts of a server form an immutable routing table
+// (a ServeMux plus the mounts it was built from). The server's handler
+// reads the current table through an atomic.Value, and addMount() and
+// removeMount() publish a rebuilt table, so mounts change without a restart
+// and without locking on the request path. Requests already in flight finish
+// on the table they started with.
+
+package main
+
+import (
+	"fmt"
+	"net/http"
+	"os"
+	"strings"
+	"sync"
+	"sync/atomic"
+)
+
+// mount is one directory served at a URL prefix
+type mount struct {
+	dir     string
+	prefix  string
+	metrics *mountMetrics
+	handler http.Handler // the mount's handler chain, below prefix stripping
+}
+
+type routeTable struct {
+	mux    *http.ServeMux
+	mounts []*mount
+}
+
+// mountPattern is the ServeMux pattern of a prefix
+func mountPattern(prefix string) string {
+	if prefix == "/" {
+		return "/"
+	}
+	return prefix + "/"
+}
+
+func newRouteTable(mounts []*mount) *routeTable {
+	mux := http.NewServeMux()
+	for _, m := range mounts {
+		// Handle root prefix "/" properly
+		if m.prefix == "/" {
+			mux.Handle("/", m.metrics.middleware(m.handler))
+		} else {
+			mux.Handle(mountPattern(m.prefix), m.metrics.middleware(http.StripPrefix(m.prefix, m.handler)))
+		}
+	}
+	return &routeTable{mux: mux, mounts: mounts}
+}
+
+// router serves requests through the current routing table
+type router struct {
+	table atomic.Value // *routeTable
+	mu    sync.Mutex   // serializes updates
+
+	// newMount builds the handler chain of a mount
+	newMount func(dir, prefix string, window int64, listing bool) *mount
+}
+
+func newRouter(newMount func(dir, prefix string, window int64, listing bool) *mount) *router {
+	rt := &router{newMount: newMount}
+	rt.table.Store(newRouteTable(nil))
+	return rt
+}
+
+func (rt *router) ServeHTTP(w http.ResponseWriter, r *http.Request) {
+	rt.table.Load().(*routeTable).mux.ServeHTTP(w, r)
+}
+
+func (rt *router) current() *routeTable {
+	return rt.table.Load().(*routeTable)
+}
+
+// metrics returns the metrics of the current mounts
+func (rt *router) metrics() []*mountMetrics {
+	mounts := rt.current().mounts
+	out := make([]*mountMetrics, len(mounts))
+	for i, m := range mounts {
+		out[i] = m.metrics
+	}
+	return out
+}
+
+// add publishes a table with a new mount appended
+func (rt *router) add(dir, prefix string, window int64, listing bool) error {
+	if info, err := os.Stat(dir); err != nil || !info.IsDir() {
+		return fmt.Errorf("%q is not a directory", dir)
+	}
+	if !strings.HasPrefix(prefix, "/") {
+		return fmt.Errorf("prefix %q must start with \"/\"", prefix)
+	}
+	if prefix != "/" && strings.HasSuffix(prefix, "/") {
+		return fmt.Errorf("prefix %q must not end with \"/\"", prefix)
+	}
+	rt.mu.Lock()
+	defer rt.mu.Unlock()
+	old := rt.current().mounts
+	for _, m := range old {
+		if mountPattern(m.prefix) == mountPattern(prefix) {
+			return fmt.Errorf("prefix %q is already mounted", prefix)
+		}
+	}
+	mounts := append(append(make([]*mount, 0, len(old)+1), old...), rt.newMount(dir, prefix, window, listing))
+	rt.table.Store(newRouteTable(mounts))
+	return nil
+}
+
+// remove publishes a table without the mount at prefix
+func (rt *router) remove(prefix string) error {
+	rt.mu.Lock()
+	defer rt.mu.Unlock()
+	old := rt.current().mounts
+	mounts := make([]*mount, 0, len(old))
+	for _, m := range old {
+		if m.prefix != prefix {
+			mounts = append(mounts, m)
+		}
+	}
+	if len(mounts) == len(old) {
+		return fmt.Errorf("prefix %q is not mounted", prefix)
+	}
+	if len(mounts) == 0 {
+		return fmt.Errorf("cannot remove the last mount")
+	}
+	rt.table.Store(newRouteTable(mounts))
+	return nil
+}
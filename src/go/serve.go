@@ -16,6 +16,7 @@ package main
 /*
 #include <stdlib.h>
 #include <stdint.h>
+#include "logring.h"
 
 // Platform-safe file handle type for passing pipe handles to Go.
 // On Windows, the C side converts CRT file descriptors to Windows HANDLEs
@@ -36,15 +37,20 @@ import (
 	"bufio"
 	"context"
 	"crypto/tls"
+	"fmt"
 	"io"
 	"log"
+	"net"
 	"net/http"
+	"net/url"
 	"os"
 	"path"
 	"path/filepath"
 	"runtime"
+	"strconv"
 	"strings"
 	"sync"
+	"sync/atomic"
 	"time"
 )
 
@@ -95,7 +101,7 @@ func safeAbs(inputPath string) (string, error) {
 }
 
 //export RunServerWithLogging
-func RunServerWithLogging(cDirs **C.char, cAddr *C.char, cPrefixes **C.char, cNumPaths C.int, cCors, cCoop, cTls, cSilent C.int, cCertFile, cKeyFile *C.char, shutdownFd, logFd C.go_pipe_handle_t, cAuthKeys *C.char, authPipeFd C.go_pipe_handle_t) {
+func RunServerWithLogging(cDirs **C.char, cAddr *C.char, cPrefixes **C.char, cNumPaths C.int, cCors, cCoop, cTls, cSilent C.int, cCertFile, cKeyFile *C.char, shutdownFd, logFd C.go_pipe_handle_t, cAuthKeys *C.char, authPipeFd C.go_pipe_handle_t, cOptions *C.char, logRing *C.goserver_log_ring_t, cServerID C.int, eventFd C.go_pipe_handle_t) {
 	addr := C.GoString(cAddr)
 	certFile := C.GoString(cCertFile)
 	keyFile := C.GoString(cKeyFile)
@@ -105,6 +111,12 @@ func RunServerWithLogging(cDirs **C.char, cAddr *C.char, cPrefixes **C.char, cNu
 	useTLS := cTls != 0
 	silent := cSilent != 0
 	numPaths := int(cNumPaths)
+	opts := parseServerOptions(C.GoString(cOptions))
+	events := newServerEvents(uintptr(eventFd), eventFd >= 0)
+	defer events.close()
+
+	// Parse the static keys once; the middleware only does set lookups
+	staticKeys := parseAuthKeys(authKeys)
 
 	// Create per-server auth manager (not global!)
 	var serverAuth *PipeAuthManager
@@ -149,54 +161,149 @@ func RunServerWithLogging(cDirs **C.char, cAddr *C.char, cPrefixes **C.char, cNu
 	// the file at the end.
 	logFile := os.NewFile(uintptr(logFd), "log-pipe")
 	var logWriter io.Writer
-	if silent {
+	var ringLog *ringLogWriter
+	var fileSink *rotatingFileWriter
+	logFlags := log.LstdFlags | log.Lmicroseconds
+	if path := opts.str("log_file", ""); path != "" {
+		// Native file sink: the log never goes through R, and no R handler
+		// drains the pipe, so a failure is reported there once and the
+		// rest of the log is dropped.
+		var err error
+		if fileSink, err = newRotatingFileWriter(path, opts); err == nil {
+			logWriter = fileSink
+		} else {
+			log.New(logFile, "", logFlags).Printf("Cannot open log file %s: %v", path, err)
+			logWriter = io.Discard
+		}
+	} else if silent {
 		logWriter = io.Discard
+	} else if logRing != nil && opts.str("log_transport", "pipe") == "ring" {
+		// Records carry their own timestamp; the pipe is only a doorbell
+		ringLog = newRingLogWriter(logRing, logFile)
+		logWriter = ringLog
+		logFlags = 0
 	} else {
 		logWriter = logFile
 	}
 
-	serveLog := log.New(logWriter, "", log.LstdFlags|log.Lmicroseconds)
+	serveLog := log.New(logWriter, "", logFlags)
+	accessLog := newAccessLog(serveLog, ringLog, opts)
+
+	readaheadWindows := parseMountInt64s(opts.str("readahead_window", ""), numPaths)
+	listings := parseMountInt64s(opts.str("dir_listing", "1"), numPaths)
+	state := &serverState{
+		id:        int(cServerID),
+		access:    accessLog,
+		logFile:   fileSink,
+		cache:     newContentCache(opts),
+		readahead: newReadaheadTracker(),
+		compress:  newCompressor(opts),
+		etags:     opts.bool("etag", true),
+		listings:  newListingCache(opts),
+		conns:     newConnLimits(opts),
+		limiter:   newRateLimiter(opts),
+		signer:    newURLSigner(opts),
+	}
 
-	mux := http.NewServeMux()
+	if len(staticKeys) > 0 || serverAuth != nil {
+		state.limiter.validKey = func(key string) bool {
+			if serverAuth != nil && serverAuth.isValidKey(key) {
+				return true
+			}
+			_, ok := staticKeys[key]
+			return ok
+		}
+	}
 
-	// Register handlers for each directory/prefix pair
-	for i := 0; i < numPaths; i++ {
-		dir := dirs[i]
-		prefix := prefixes[i]
+	var tlsErr error
+	if useTLS {
+		state.tls, tlsErr = newTLSState(certFile, keyFile, opts)
+	}
 
-		fileHandler := serveLogger(serveLog, http.FileServer(http.Dir(dir)))
+	// Wrap a handler in logging, auth, rate limiting, CORS/COOP and the
+	// access ring
+	protect := func(handler http.Handler) http.Handler {
+		handler = serveLogger(accessLog, handler)
 
-		// Add auth middleware if auth keys are provided or auth pipe exists
-		if authKeys != "" || serverAuth != nil {
-			fileHandler = authMiddleware(fileHandler, authKeys, serveLog, serverAuth)
+		// Add auth middleware if auth keys are provided, auth pipe exists
+		// or URLs are signed
+		if len(staticKeys) > 0 || serverAuth != nil || state.signer != nil {
+			handler = authMiddleware(handler, staticKeys, accessLog, serverAuth, state.signer)
 		}
+		handler = state.limiter.middleware(handler)
 
 		if cors {
-			fileHandler = enableCORS(fileHandler)
+			handler = enableCORS(handler)
 		}
 		if coop {
-			fileHandler = enableCOOP(fileHandler)
+			handler = enableCOOP(handler)
 		}
+		return accessLog.records.middleware(handler)
+	}
 
-		// Handle root prefix "/" properly
-		if prefix == "/" {
-			mux.Handle("/", fileHandler)
+	// Build the handler chain of a directory/prefix pair
+	newMount := func(dir, prefix string, window int64, listing bool) *mount {
+		metrics := newMountMetrics(prefix, dir)
+		fileHandler := protect(newStaticHandler(dir, state, metrics, window, listing))
+		serveLog.Printf("Registered handler for directory %q at prefix %q", dir, prefix)
+		return &mount{dir: dir, prefix: prefix, metrics: metrics, handler: fileHandler}
+	}
+	state.routes = newRouter(newMount)
+	mounts := make([]*mount, numPaths)
+	for i := range mounts {
+		mounts[i] = newMount(dirs[i], prefixes[i], readaheadWindows[i], listings[i] != 0)
+	}
+	state.routes.table.Store(newRouteTable(mounts))
+	state.published = newRawStore(state.routes, protect)
+
+	registerServer(state)
+	defer unregisterServer(state.id)
+	// Runs first: R may release published vectors once the server is gone
+	defer state.published.close()
+
+	// Optional Prometheus endpoint on its own address
+	var metricsSrv *http.Server
+	if metricsAddr := opts.str("metrics_addr", ""); metricsAddr != "" {
+		metricsMux := http.NewServeMux()
+		metricsMux.Handle("/metrics", metricsHandler(state))
+		metricsSrv = &http.Server{Addr: metricsAddr, Handler: metricsMux}
+		go func() {
+			serveLog.Printf("Serving metrics on http://%v/metrics", metricsAddr)
+			if err := metricsSrv.ListenAndServe(); err != http.ErrServerClosed {
+				serveLog.Printf("Metrics server error: %v", err)
+			}
+		}()
+	}
+
+	// Optional net/http/pprof endpoint on its own loopback address
+	applyProfileRates(opts)
+	var pprofSrv *http.Server
+	if pprofAddr := opts.str("pprof_addr", ""); pprofAddr != "" {
+		var pprofLn net.Listener
+		var err error
+		if pprofSrv, pprofLn, err = newPprofServer(pprofAddr); err != nil {
+			serveLog.Printf("Profiling server error: %v", err)
 		} else {
-			mux.Handle(prefix+"/", http.StripPrefix(prefix, fileHandler))
+			go func() {
+				serveLog.Printf("Serving profiles on http://%v/debug/pprof/", pprofLn.Addr())
+				if err := pprofSrv.Serve(pprofLn); err != http.ErrServerClosed {
+					serveLog.Printf("Profiling server error: %v", err)
+				}
+			}()
 		}
-
-		serveLog.Printf("Registered handler for directory %q at prefix %q", dir, prefix)
 	}
 
 	srv := &http.Server{
-		Addr:    addr,
-		Handler: mux,
+		Addr:              addr,
+		Handler:           state.published,
+		ReadTimeout:       opts.duration("read_timeout", 0),
+		ReadHeaderTimeout: opts.duration("read_header_timeout", 10*time.Second),
+		WriteTimeout:      opts.duration("write_timeout", 0),
+		IdleTimeout:       opts.duration("idle_timeout", 120*time.Second),
+		MaxHeaderBytes:    int(opts.int64("max_header_bytes", http.DefaultMaxHeaderBytes)),
 	}
-	if useTLS {
-		srv.TLSConfig = &tls.Config{
-			MinVersion:               tls.VersionTLS12,
-			PreferServerCipherSuites: true,
-		}
+	if state.tls != nil {
+		srv.TLSConfig = state.tls.config
 	}
 
 	serverClosed := make(chan struct{})
@@ -205,6 +312,7 @@ func RunServerWithLogging(cDirs **C.char, cAddr *C.char, cPrefixes **C.char, cNu
 		defer func() {
 			if r := recover(); r != nil {
 				serveLog.Printf("PANIC: Server panicked: %v", r)
+				events.send("error", fmt.Sprintf("server panicked: %v", r))
 				close(serverClosed)
 			}
 		}()
@@ -215,17 +323,41 @@ func RunServerWithLogging(cDirs **C.char, cAddr *C.char, cPrefixes **C.char, cNu
 			serveLog.Printf("Serving %d directories on http://%v", numPaths, addr)
 		}
 
-		if useTLS {
-			if err := srv.ListenAndServeTLS(certFile, keyFile); err != http.ErrServerClosed {
-				serveLog.Printf("HTTPS server error: %v", err)
-				close(serverClosed)
-				return
+		err := tlsErr
+		var listeners []net.Listener
+		if err == nil {
+			listeners, err = listen(addr, opts, state.conns)
+		}
+		if err == nil {
+			// One accept loop per listener; Shutdown closes them all
+			errs := make(chan error, len(listeners))
+			for _, ln := range listeners {
+				if useTLS {
+					// The listener uses the live config, so certificate reloads
+					// and ticket key rotation apply to new connections
+					ln = tls.NewListener(ln, srv.TLSConfig)
+				}
+				go func(ln net.Listener) { errs <- srv.Serve(ln) }(ln)
 			}
-		} else {
-			if err := srv.ListenAndServe(); err != http.ErrServerClosed {
+			if len(listeners) > 1 {
+				serveLog.Printf("Accepting on %d SO_REUSEPORT listeners", len(listeners))
+			}
+			events.send("ready", listeners[0].Addr().String())
+			err = <-errs
+			if err != http.ErrServerClosed {
+				// One accept loop failed; stop the others too
+				srv.Close()
+			}
+			for range listeners[1:] {
+				<-errs
+			}
+		}
+		if err != http.ErrServerClosed {
+			events.send("error", err.Error())
+			if useTLS {
+				serveLog.Printf("HTTPS server error: %v", err)
+			} else {
 				serveLog.Printf("HTTP server error: %v", err)
-				close(serverClosed)
-				return
 			}
 		}
 		close(serverClosed)
@@ -253,6 +385,15 @@ func RunServerWithLogging(cDirs **C.char, cAddr *C.char, cPrefixes **C.char, cNu
 	defer cancel()
 	_ = srv.Shutdown(ctx)
 	<-serverClosed
+	if metricsSrv != nil {
+		_ = metricsSrv.Shutdown(ctx)
+	}
+	if pprofSrv != nil {
+		_ = pprofSrv.Shutdown(ctx)
+	}
+	if state.tls != nil {
+		state.tls.close()
+	}
 
 	// Clean up per-server auth (not global!)
 	if serverAuth != nil {
@@ -265,15 +406,28 @@ func RunServerWithLogging(cDirs **C.char, cAddr *C.char, cPrefixes **C.char, cNu
 	// finalizers — potentially after C has already freed the server struct
 	// or closed its own handles. Closing here is deterministic and safe.
 	shutdownFile.Close()
+	if fileSink != nil {
+		fileSink.close()
+	}
+	if ringLog != nil {
+		ringLog.close()
+	}
 	logFile.Close()
 }
 
-// serveLogger logs HTTP requests to the given logger
-func serveLogger(logger *log.Logger, next http.Handler) http.Handler {
+// serveLogger logs HTTP requests through the server's access log policy.
+// It reuses the recorder installed by the mount metrics when there is one.
+func serveLogger(al *accessLog, next http.Handler) http.Handler {
 	return http.HandlerFunc(func(w http.ResponseWriter, r *http.Request) {
 		start := time.Now()
-		next.ServeHTTP(w, r)
-		logger.Printf("%s %s %s %s", r.Method, r.RequestURI, r.RemoteAddr, time.Since(start))
+		rec, ok := w.(*responseRecorder)
+		if !ok {
+			rec = &responseRecorder{ResponseWriter: w}
+		}
+		next.ServeHTTP(rec, r)
+		if d := time.Since(start); al.shouldLog(rec.statusCode(), d) {
+			al.request(start, d, r)
+		}
 	})
 }
 
@@ -301,58 +455,120 @@ func enableCOOP(next http.Handler) http.Handler {
 	})
 }
 
+// authKeySet is an immutable set of API keys. Once published it is never
+// modified, so request handlers can read it without locking.
+type authKeySet map[string]struct{}
+
+// parseAuthKeys builds a key set from a comma-separated key list
+func parseAuthKeys(keys string) authKeySet {
+	set := make(authKeySet)
+	for _, key := range strings.Split(keys, ",") {
+		if key = strings.TrimSpace(key); key != "" {
+			set[key] = struct{}{}
+		}
+	}
+	return set
+}
+
+// queryValue returns the first value of name in a raw query string without
+// building the url.Values map
+func queryValue(rawQuery, name string) string {
+	for rawQuery != "" {
+		var pair string
+		if i := strings.IndexByte(rawQuery, '&'); i >= 0 {
+			pair, rawQuery = rawQuery[:i], rawQuery[i+1:]
+		} else {
+			pair, rawQuery = rawQuery, ""
+		}
+		if !strings.HasPrefix(pair, name) {
+			continue
+		}
+		rest := pair[len(name):]
+		if rest == "" {
+			return ""
+		}
+		if rest[0] != '=' {
+			continue
+		}
+		value, err := url.QueryUnescape(rest[1:])
+		if err != nil {
+			return ""
+		}
+		return value
+	}
+	return ""
+}
+
 // authMiddleware adds pipe-based authentication
-func authMiddleware(next http.Handler, validKeys string, logger *log.Logger, pipeAuth *PipeAuthManager) http.Handler {
+func authMiddleware(next http.Handler, staticKeys authKeySet, al *accessLog, pipeAuth *PipeAuthManager, signer *urlSigner) http.Handler {
 	return http.HandlerFunc(func(w http.ResponseWriter, r *http.Request) {
-		// Check auth key in header or query parameter
-		authKey := r.Header.Get("X-API-Key")
-		if authKey == "" {
-			authKey = r.URL.Query().Get("api_key")
+		// A signed URL is checked on its own, without key state
+		if signer != nil {
+			if signed, expires := signer.check(r); signed {
+				if expires == 0 {
+					al.auth(false, "Auth denied - invalid or expired signature from %s for %s", r.RemoteAddr, r.RequestURI)
+					http.Error(w, "Forbidden", http.StatusForbidden)
+					return
+				}
+				al.auth(true, "Auth granted (signed URL) from %s for %s", r.RemoteAddr, r.RequestURI)
+				// The URL itself is the credential, so shared caches may keep
+				// the response until the link expires
+				w.Header().Set("Cache-Control", fmt.Sprintf("public, max-age=%d", expires-time.Now().Unix()))
+				next.ServeHTTP(w, r)
+				return
+			}
 		}
 
 		// If no pipe auth manager and no static keys, allow access (no auth)
-		if pipeAuth == nil && validKeys == "" {
+		if pipeAuth == nil && len(staticKeys) == 0 && signer == nil {
 			next.ServeHTTP(w, r)
 			return
 		}
 
+		// Check auth key in header or query parameter
+		authKey := r.Header.Get("X-API-Key")
+		if authKey == "" {
+			authKey = queryValue(r.URL.RawQuery, "api_key")
+		}
+
 		// Check pipe-based auth first (if available)
 		if pipeAuth != nil && authKey != "" && pipeAuth.isValidKey(authKey) {
-			logger.Printf("Auth granted (pipe) from %s for %s", r.RemoteAddr, r.RequestURI)
+			al.auth(true, "Auth granted (pipe) from %s for %s", r.RemoteAddr, r.RequestURI)
 			next.ServeHTTP(w, r)
 			return
 		}
 
 		// Fall back to static keys (backward compatibility)
-		if validKeys != "" && authKey != "" {
-			for _, validKey := range strings.Split(validKeys, ",") {
-				if strings.TrimSpace(validKey) == authKey {
-					logger.Printf("Auth granted (static) from %s for %s", r.RemoteAddr, r.RequestURI)
-					next.ServeHTTP(w, r)
-					return
-				}
+		if authKey != "" {
+			if _, ok := staticKeys[authKey]; ok {
+				al.auth(true, "Auth granted (static) from %s for %s", r.RemoteAddr, r.RequestURI)
+				next.ServeHTTP(w, r)
+				return
 			}
 		}
 
-		logger.Printf("Auth denied - invalid key from %s for %s", r.RemoteAddr, r.RequestURI)
+		al.auth(false, "Auth denied - invalid key from %s for %s", r.RemoteAddr, r.RequestURI)
 		http.Error(w, "Unauthorized", http.StatusUnauthorized)
 	})
 }
 
-// Pipe-based authentication manager
+// Pipe-based authentication manager.
+// The current key set is published through an atomic.Value so lookups on
+// the request path never contend with updates arriving on the auth pipe.
+// Updates are copy-on-write: processCommand builds a new set and swaps it in.
 type PipeAuthManager struct {
-	keys     map[string]bool
-	mutex    sync.RWMutex
+	keys     atomic.Value // holds authKeySet
+	mutex    sync.Mutex   // serializes writers only
 	authPipe *os.File
 	done     chan bool
 }
 
 func NewPipeAuthManager(pipeFd uintptr) *PipeAuthManager {
 	pam := &PipeAuthManager{
-		keys:     make(map[string]bool),
 		done:     make(chan bool),
 		authPipe: os.NewFile(pipeFd, "auth_pipe"),
 	}
+	pam.keys.Store(make(authKeySet))
 
 	go pam.listenForCommands()
 	return pam
@@ -370,11 +586,34 @@ func (pam *PipeAuthManager) listenForCommands() {
 			return
 		default:
 			cmd := strings.TrimSpace(scanner.Text())
+			if strings.HasPrefix(cmd, "SET:") {
+				pam.readKeySet(scanner, cmd)
+				continue
+			}
 			pam.processCommand(cmd)
 		}
 	}
 }
 
+// readKeySet reads the n key lines following a "SET:<n>" frame and swaps
+// them in as the whole key set, so bulk loads and rotations cost one copy
+// instead of one per key
+func (pam *PipeAuthManager) readKeySet(scanner *bufio.Scanner, cmd string) {
+	n, err := strconv.Atoi(strings.TrimPrefix(cmd, "SET:"))
+	if err != nil || n < 0 {
+		return
+	}
+	next := make(authKeySet, n)
+	for i := 0; i < n && scanner.Scan(); i++ {
+		if key := strings.TrimSpace(scanner.Text()); key != "" {
+			next[key] = struct{}{}
+		}
+	}
+	pam.mutex.Lock()
+	pam.keys.Store(next)
+	pam.mutex.Unlock()
+}
+
 func (pam *PipeAuthManager) processCommand(cmd string) {
 	parts := strings.SplitN(cmd, ":", 2)
 	if len(parts) != 2 {
@@ -386,13 +625,31 @@ func (pam *PipeAuthManager) processCommand(cmd string) {
 	pam.mutex.Lock()
 	defer pam.mutex.Unlock()
 
+	current := pam.keys.Load().(authKeySet)
 	switch action {
 	case "ADD":
-		pam.keys[key] = true
+		if _, ok := current[key]; ok {
+			return
+		}
+		next := make(authKeySet, len(current)+1)
+		for k := range current {
+			next[k] = struct{}{}
+		}
+		next[key] = struct{}{}
+		pam.keys.Store(next)
 	case "REMOVE":
-		delete(pam.keys, key)
+		if _, ok := current[key]; !ok {
+			return
+		}
+		next := make(authKeySet, len(current))
+		for k := range current {
+			if k != key {
+				next[k] = struct{}{}
+			}
+		}
+		pam.keys.Store(next)
 	case "CLEAR":
-		pam.keys = make(map[string]bool)
+		pam.keys.Store(make(authKeySet))
 	}
 }
 
@@ -400,9 +657,8 @@ func (pam *PipeAuthManager) isValidKey(key string) bool {
 	if pam == nil {
 		return false
 	}
-	pam.mutex.RLock()
-	defer pam.mutex.RUnlock()
-	return pam.keys[key]
+	_, ok := pam.keys.Load().(authKeySet)[key]
+	return ok
 }
 
 func (pam *PipeAuthManager) close() {
@@ -0,0 +1,151 @@
+//go:build ignore
+// +build ignore
+
+// Static file handler.
+//
+// staticHandler sits where http.FileServer used to be. Regular files are
+// served directly with http.ServeContent, which handles Range and
+// conditional requests just like http.FileServer: compressed variants (see
+// compress.go), files it can answer from memory, and everything else from a
+// descriptor it opens itself, so that readahead hints apply and the strong
+// ETag (see etag.go) comes from the same fstat as the bytes. Everything
+// else (directories, index.html redirects, missing files) falls through to
+// http.FileServer unchanged. Directory listings come from listing.go.
+
+package main
+
+import (
+	"bytes"
+	"net/http"
+	"os"
+	"path"
+	"path/filepath"
+	"strings"
+)
+
+type staticHandler struct {
+	dir      string
+	files    http.Handler
+	cache    *contentCache // nil when caching is disabled
+	compress *compressor   // nil when compression is disabled
+	etags    bool
+	listings *listingCache
+	listing  bool // directories without index.html are listed, not 404
+	metrics  *mountMetrics
+
+	readahead *readaheadTracker // nil when readahead hints are disabled
+	window    int64             // initial readahead window of this mount
+}
+
+func newStaticHandler(dir string, state *serverState, metrics *mountMetrics, window int64, listing bool) *staticHandler {
+	h := &staticHandler{
+		dir:      dir,
+		files:    http.FileServer(http.Dir(dir)),
+		cache:    state.cache,
+		compress: state.compress,
+		etags:    state.etags,
+		listings: state.listings,
+		listing:  listing,
+		metrics:  metrics,
+	}
+	if window > 0 && state.readahead != nil {
+		h.readahead, h.window = state.readahead, window
+	}
+	return h
+}
+
+// fsPath maps a URL path to a file name the way http.Dir does
+func (h *staticHandler) fsPath(urlPath string) (string, bool) {
+	if filepath.Separator != '/' && strings.ContainsRune(urlPath, filepath.Separator) {
+		return "", false
+	}
+	return filepath.Join(h.dir, filepath.FromSlash(path.Clean("/"+urlPath))), true
+}
+
+// resolve maps a URL path to a file name. It reports false for paths that
+// http.FileServer treats specially.
+func (h *staticHandler) resolve(urlPath string) (string, bool) {
+	if strings.HasSuffix(urlPath, "/") || strings.HasSuffix(urlPath, "/index.html") {
+		return "", false
+	}
+	return h.fsPath(urlPath)
+}
+
+func (h *staticHandler) ServeHTTP(w http.ResponseWriter, r *http.Request) {
+	if strings.HasSuffix(r.URL.Path, "/") {
+		h.serveDir(w, r)
+		return
+	}
+	name, ok := h.resolve(r.URL.Path)
+	if !ok {
+		h.files.ServeHTTP(w, r)
+		return
+	}
+	if h.compress != nil && (r.Method == http.MethodGet || r.Method == http.MethodHead) &&
+		h.compress.serve(w, r, name, h.etags) {
+		return
+	}
+	if h.cache != nil && (r.Method == http.MethodGet || r.Method == http.MethodHead) {
+		// Files that cannot be cached count as neither hits nor misses
+		entry, hit := h.cache.get(name)
+		if hit {
+			h.metrics.cacheHits.Add(1)
+		} else if entry != nil {
+			h.metrics.cacheMisses.Add(1)
+		}
+		if entry != nil {
+			if h.etags {
+				w.Header().Set("ETag", entry.etag)
+			}
+			http.ServeContent(w, r, name, entry.modTime, bytes.NewReader(entry.data))
+			return
+		}
+	}
+	if h.serveFile(w, r, name) {
+		return
+	}
+	h.files.ServeHTTP(w, r)
+}
+
+// serveDir answers a request for a directory with its listing, leaving
+// index.html and non-directories to http.FileServer
+func (h *staticHandler) serveDir(w http.ResponseWriter, r *http.Request) {
+	name, ok := h.fsPath(r.URL.Path)
+	var listing *dirListing
+	if ok {
+		listing = h.listings.get(name)
+	}
+	switch {
+	case listing == nil || listing.hasIndex:
+		h.files.ServeHTTP(w, r)
+	case !h.listing:
+		http.NotFound(w, r)
+	default:
+		listing.serve(w, r)
+	}
+}
+
+// serveFile serves a regular file from its own descriptor, with readahead
+// hints for Range requests. It reports false if the request should go to
+// http.FileServer instead.
+func (h *staticHandler) serveFile(w http.ResponseWriter, r *http.Request, name string) bool {
+	f, err := os.Open(name)
+	if err != nil {
+		return false
+	}
+	defer f.Close()
+	info, err := f.Stat()
+	if err != nil || !info.Mode().IsRegular() {
+		return false
+	}
+	if h.etags {
+		w.Header().Set("ETag", makeETag(info))
+	}
+	if h.readahead != nil && r.Method == http.MethodGet {
+		if start, end, ok := firstRange(r.Header.Get("Range"), info.Size()); ok {
+			h.readahead.advise(f, clientHost(r.RemoteAddr), name, start, end, info.Size(), h.window)
+		}
+	}
+	http.ServeContent(w, r, info.Name(), info.ModTime(), f)
+	return true
+}
@@ -0,0 +1,182 @@
+//go:build ignore
+// +build ignore
+
+// TLS configuration.
+//
+// The certificate is served through GetCertificate so it can be swapped
+// without a restart: the certificate and key files are checked for changes
+// at most once per reload interval during handshakes, and reloadTLS() forces
+// a reload. A failed reload keeps the previous certificate. Session tickets
+// let returning clients skip the full handshake; their keys are rotated
+// periodically, and the previous keys are kept for a while so tickets issued
+// just before a rotation still resume.
+
+package main
+
+import (
+	"crypto/rand"
+	"crypto/tls"
+	"fmt"
+	"os"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+const tlsTicketKeys = 3 // current key plus the ones it replaced
+
+type tlsState struct {
+	fullHandshakes atomic.Uint64
+	reloads        atomic.Uint64
+	reloadErrors   atomic.Uint64
+	nextCheck      atomic.Int64 // UnixNano of the next file check
+
+	certFile, keyFile string
+	cert              atomic.Value // *tls.Certificate
+	checkEvery        time.Duration
+
+	mu               sync.Mutex // serializes reloads and ticket rotation
+	certMod, keyMod  time.Time
+	tickets          [][32]byte
+	config           *tls.Config
+	stopRotation     chan struct{}
+	rotationFinished chan struct{}
+}
+
+// newTLSState loads the certificate and builds the server's TLS config
+func newTLSState(certFile, keyFile string, opts serverOptions) (*tlsState, error) {
+	s := &tlsState{
+		certFile:   certFile,
+		keyFile:    keyFile,
+		checkEvery: opts.duration("tls_reload_interval", 10*time.Second),
+	}
+	if err := s.reload(); err != nil {
+		return nil, err
+	}
+	s.reloads.Store(0)
+
+	s.config = &tls.Config{
+		MinVersion: tls.VersionTLS12,
+		// X25519 is the cheapest ECDHE; P-256 has fast assembly everywhere
+		CurvePreferences: []tls.CurveID{tls.X25519, tls.CurveP256},
+		// TLS 1.2 only; TLS 1.3 suites are not configurable
+		CipherSuites: []uint16{
+			tls.TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+			tls.TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+			tls.TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305,
+			tls.TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305,
+			tls.TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384,
+			tls.TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384,
+		},
+		GetCertificate:         s.getCertificate,
+		SessionTicketsDisabled: !opts.bool("tls_session_tickets", true),
+		// Served through tls.NewListener, so ALPN is not filled in by net/http
+		NextProtos: []string{"h2", "http/1.1"},
+	}
+
+	// Without explicit rotation crypto/tls rotates its own keys daily
+	if rotate := opts.duration("tls_ticket_rotate", time.Hour); rotate > 0 && !s.config.SessionTicketsDisabled {
+		if err := s.rotateTicketKey(); err != nil {
+			return nil, err
+		}
+		s.stopRotation = make(chan struct{})
+		s.rotationFinished = make(chan struct{})
+		go s.rotateLoop(rotate)
+	}
+	return s, nil
+}
+
+// getCertificate is the tls.Config callback, called for full handshakes only
+func (s *tlsState) getCertificate(*tls.ClientHelloInfo) (*tls.Certificate, error) {
+	s.fullHandshakes.Add(1)
+	if s.checkEvery > 0 {
+		now := time.Now().UnixNano()
+		next := s.nextCheck.Load()
+		if now >= next && s.nextCheck.CompareAndSwap(next, now+int64(s.checkEvery)) && s.changed() {
+			s.reload() // errors are counted; the old certificate stays
+		}
+	}
+	return s.cert.Load().(*tls.Certificate), nil
+}
+
+// changed reports whether the certificate or key file changed since the
+// last load
+func (s *tlsState) changed() bool {
+	certInfo, err1 := os.Stat(s.certFile)
+	keyInfo, err2 := os.Stat(s.keyFile)
+	if err1 != nil || err2 != nil {
+		return false
+	}
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	return !certInfo.ModTime().Equal(s.certMod) || !keyInfo.ModTime().Equal(s.keyMod)
+}
+
+// reload reads the certificate and key files and swaps them in
+func (s *tlsState) reload() error {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	certInfo, err := os.Stat(s.certFile)
+	if err == nil {
+		var keyInfo os.FileInfo
+		if keyInfo, err = os.Stat(s.keyFile); err == nil {
+			var cert tls.Certificate
+			if cert, err = tls.LoadX509KeyPair(s.certFile, s.keyFile); err == nil {
+				s.cert.Store(&cert)
+				s.certMod, s.keyMod = certInfo.ModTime(), keyInfo.ModTime()
+				s.reloads.Add(1)
+				return nil
+			}
+		}
+	}
+	s.reloadErrors.Add(1)
+	return fmt.Errorf("loading TLS certificate: %v", err)
+}
+
+// rotateTicketKey makes a new session ticket key current
+func (s *tlsState) rotateTicketKey() error {
+	var key [32]byte
+	if _, err := rand.Read(key[:]); err != nil {
+		return fmt.Errorf("generating session ticket key: %v", err)
+	}
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	s.tickets = append([][32]byte{key}, s.tickets...)
+	if len(s.tickets) > tlsTicketKeys {
+		s.tickets = s.tickets[:tlsTicketKeys]
+	}
+	if s.config != nil {
+		s.config.SetSessionTicketKeys(s.tickets)
+	}
+	return nil
+}
+
+func (s *tlsState) rotateLoop(every time.Duration) {
+	defer close(s.rotationFinished)
+	ticker := time.NewTicker(every)
+	defer ticker.Stop()
+	for {
+		select {
+		case <-ticker.C:
+			s.rotateTicketKey()
+		case <-s.stopRotation:
+			return
+		}
+	}
+}
+
+func (s *tlsState) close() {
+	if s.stopRotation != nil {
+		close(s.stopRotation)
+		<-s.rotationFinished
+	}
+}
+
+// counters returns the TLS counters as name/value pairs
+func (s *tlsState) counters() []counter {
+	return []counter{
+		{"tls_full_handshakes", s.fullHandshakes.Load()},
+		{"tls_reloads", s.reloads.Load()},
+		{"tls_reload_errors", s.reloadErrors.Load()},
+	}
+}
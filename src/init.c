@@ -6,21 +6,36 @@
 #include <signal.h>
 
 // Make sure the declaration matches the implementation
-SEXP run_server(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+SEXP run_server(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
 SEXP list_servers();
 SEXP shutdown_server(SEXP);
 SEXP is_running(SEXP);
-SEXP register_log_handler(SEXP, SEXP, SEXP);
+SEXP get_server_counters(SEXP);
+SEXP server_query(SEXP, SEXP);
+SEXP server_command(SEXP, SEXP);
+SEXP server_mount(SEXP, SEXP, SEXP, SEXP);
+SEXP server_events(SEXP, SEXP);
+SEXP server_address(SEXP);
+SEXP publish_raw(SEXP, SEXP, SEXP, SEXP);
+SEXP unpublish_raw(SEXP, SEXP, SEXP);
+SEXP load_start(SEXP);
+SEXP load_result(SEXP);
+SEXP start_profile(SEXP, SEXP, SEXP);
+SEXP stop_profile(SEXP);
+SEXP set_server_runtime(SEXP);
+SEXP server_runtime_stats();
+SEXP register_log_handler(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
 SEXP remove_log_handler(SEXP);
 
 // Auth management functions (new server-based)
 SEXP manage_server_auth(SEXP, SEXP, SEXP);
 SEXP list_server_auth_keys(SEXP);
 SEXP add_initial_server_auth_keys(SEXP, SEXP);
+SEXP set_server_auth_keys(SEXP, SEXP);
 
 // RC-level (raw C) entry points
-SEXP RC_StartServer(SEXP r_dir, SEXP r_addr, SEXP r_prefix, SEXP r_blocking, SEXP r_cors, SEXP r_coop, SEXP r_tls, SEXP r_certfile, SEXP r_keyfile, SEXP r_silent, SEXP r_log_handler, SEXP r_auth_keys) {
-    return run_server(r_dir, r_addr, r_prefix, r_blocking, r_cors, r_coop, r_tls, r_certfile, r_keyfile, r_silent, r_log_handler, r_auth_keys);
+SEXP RC_StartServer(SEXP r_dir, SEXP r_addr, SEXP r_prefix, SEXP r_blocking, SEXP r_cors, SEXP r_coop, SEXP r_tls, SEXP r_certfile, SEXP r_keyfile, SEXP r_silent, SEXP r_log_handler, SEXP r_auth_keys, SEXP r_options) {
+    return run_server(r_dir, r_addr, r_prefix, r_blocking, r_cors, r_coop, r_tls, r_certfile, r_keyfile, r_silent, r_log_handler, r_auth_keys, r_options);
 }
 SEXP RC_ListServers() {
     return list_servers();
@@ -36,15 +51,30 @@ SEXP RC_IsRunning(SEXP extptr) {
 static const R_CallMethodDef CallEntries[] = {
     {"RC_list_servers", (DL_FUNC) &list_servers, 0},
     {"RC_shutdown_server", (DL_FUNC) &shutdown_server, 1},
-    {"RC_StartServer", (DL_FUNC) &RC_StartServer, 12},
+    {"RC_StartServer", (DL_FUNC) &RC_StartServer, 13},
     {"RC_ListServers", (DL_FUNC) &RC_ListServers, 0},
     {"RC_ShutdownServer", (DL_FUNC) &RC_ShutdownServer, 1},
     {"RC_is_running", (DL_FUNC) &is_running, 1},
-    {"RC_register_log_handler", (DL_FUNC) &register_log_handler, 3},
+    {"RC_get_server_counters", (DL_FUNC) &get_server_counters, 1},
+    {"RC_server_query", (DL_FUNC) &server_query, 2},
+    {"RC_server_command", (DL_FUNC) &server_command, 2},
+    {"RC_server_mount", (DL_FUNC) &server_mount, 4},
+    {"RC_server_events", (DL_FUNC) &server_events, 2},
+    {"RC_server_address", (DL_FUNC) &server_address, 1},
+    {"RC_publish_raw", (DL_FUNC) &publish_raw, 4},
+    {"RC_unpublish_raw", (DL_FUNC) &unpublish_raw, 3},
+    {"RC_load_start", (DL_FUNC) &load_start, 1},
+    {"RC_load_result", (DL_FUNC) &load_result, 1},
+    {"RC_start_profile", (DL_FUNC) &start_profile, 3},
+    {"RC_stop_profile", (DL_FUNC) &stop_profile, 1},
+    {"RC_set_server_runtime", (DL_FUNC) &set_server_runtime, 1},
+    {"RC_server_runtime_stats", (DL_FUNC) &server_runtime_stats, 0},
+    {"RC_register_log_handler", (DL_FUNC) &register_log_handler, 6},
     {"RC_remove_log_handler", (DL_FUNC) &remove_log_handler, 1},
     {"RC_manage_server_auth", (DL_FUNC) &manage_server_auth, 3},
     {"RC_list_server_auth_keys", (DL_FUNC) &list_server_auth_keys, 1},
     {"RC_add_initial_server_auth_keys", (DL_FUNC) &add_initial_server_auth_keys, 2},
+    {"RC_set_server_auth_keys", (DL_FUNC) &set_server_auth_keys, 2},
     {NULL, NULL, 0}
 };
 
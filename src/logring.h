@@ -0,0 +1,85 @@
+#ifndef _GOSERVER_LOGRING_H_
+#define _GOSERVER_LOGRING_H_
+
+// Shared-memory log ring between the Go server (producer) and the R main
+// thread (consumer). Both sides live in the same process, so the ring is a
+// plain heap block allocated by C and handed to Go. Go serializes its writers
+// and is the single producer; the log input handler in background.c is the
+// single consumer. The log pipe is only used as a doorbell: Go writes one byte
+// when the consumer has announced that it is going back to sleep.
+//
+// This header is included from both the C sources and the cgo preambles, so
+// it must only contain declarations and static inline helpers.
+
+#include <stdint.h>
+
+#define GOSERVER_LOG_RING_SLOTS 4096 // must be a power of two
+#define GOSERVER_LOG_TEXT_LEN 192
+#define GOSERVER_LOG_REMOTE_LEN 48
+
+#define GOSERVER_LOG_KIND_MESSAGE 0 // free-form message in text
+#define GOSERVER_LOG_KIND_ACCESS 1  // access record, request URI in text
+
+#define GOSERVER_LOG_FLAG_TRUNCATED 1 // a string did not fit its field
+
+// One fixed-layout record (256 bytes). Strings are always NUL-terminated;
+// longer ones (text beyond GOSERVER_LOG_TEXT_LEN - 1 bytes, typically long
+// request URIs) are cut, flagged and counted.
+typedef struct {
+    int64_t time_ns;     // wall clock, nanoseconds since the Unix epoch
+    int64_t duration_ns; // request duration (access records only)
+    int32_t kind;
+    int32_t flags;
+    char method[8];
+    char remote[GOSERVER_LOG_REMOTE_LEN];
+    char text[GOSERVER_LOG_TEXT_LEN];
+} goserver_log_record_t;
+
+typedef struct {
+    uint64_t head; // next slot the producer writes
+    char pad_head[56];
+    uint64_t tail; // next slot the consumer reads
+    char pad_tail[56];
+    uint64_t dropped;   // records lost because the ring was full
+    uint64_t truncated; // records with a string cut to fit
+    int32_t waiting;  // consumer is idle and needs a doorbell byte
+    int32_t closed;   // producer is gone; no more records will arrive
+    goserver_log_record_t slots[GOSERVER_LOG_RING_SLOTS];
+} goserver_log_ring_t;
+
+// Consumer side: return the next record or NULL when the ring is empty.
+// The caller must call goserver_log_ring_release() once done with it.
+static inline goserver_log_record_t* goserver_log_ring_peek(goserver_log_ring_t* ring) {
+    uint64_t tail = ring->tail;
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    if (tail == head) return 0;
+    return &ring->slots[tail & (GOSERVER_LOG_RING_SLOTS - 1)];
+}
+
+static inline void goserver_log_ring_release(goserver_log_ring_t* ring) {
+    __atomic_store_n(&ring->tail, ring->tail + 1, __ATOMIC_RELEASE);
+}
+
+// Consumer side: announce that the consumer is about to sleep. Returns
+// non-zero if records arrived in the meantime and the consumer must drain
+// again instead of sleeping.
+static inline int goserver_log_ring_sleep(goserver_log_ring_t* ring) {
+    __atomic_store_n(&ring->waiting, 1, __ATOMIC_SEQ_CST);
+    return __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) != ring->tail;
+}
+
+// Consumer side: non-zero once the producer has closed the ring. Records
+// pushed before the close are visible once this returns non-zero.
+static inline int goserver_log_ring_closed(goserver_log_ring_t* ring) {
+    return __atomic_load_n(&ring->closed, __ATOMIC_ACQUIRE);
+}
+
+static inline uint64_t goserver_log_ring_take_dropped(goserver_log_ring_t* ring) {
+    return __atomic_exchange_n(&ring->dropped, 0, __ATOMIC_ACQ_REL);
+}
+
+static inline uint64_t goserver_log_ring_take_truncated(goserver_log_ring_t* ring) {
+    return __atomic_exchange_n(&ring->truncated, 0, __ATOMIC_ACQ_REL);
+}
+
+#endif